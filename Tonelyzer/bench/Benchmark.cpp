@@ -0,0 +1,558 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sndfile.h>
+
+#include "Structures.h"
+#include "Reader.h"
+#include "Transformer.h"
+#include "PitchAnalyzer.h"
+#include "BufferSource.h"
+#include "AnalyzerContext.h"
+#include "Simd.h"
+
+#if defined(_WIN32)
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+// A feldolgozsi lnc lpseinek mrprogramja (tonelyzer_bench). Minden lps paramterenknt
+// bemelegt futsok utn legalbb -reps mintt, s legalbb -time msodpercig mr; a nagyon rvid
+// hvsok egy mintn bell tbbszr futnak, hogy az ra felbontsa ne torztson. A bemenetek a
+// folyamatban kszlnek (a test_files/sin_*.wav hangjaihoz hasonl szinuszok), a hangfjlok egy
+// ideiglenes knyvtrba rdnak, s a vgn trldnek. Az eredmny JSON a szabvnyos kimeneten
+// (vagy a -o fjlban), a halads a hibakimeneten jelenik meg.
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchSettings
+{
+	unsigned Warmup = 2;        // legalbb 1: ebbl becsljk a mintnknti hvsszmot
+	unsigned MinReps = 5;
+	double MinTime = 0.3;       // msodperc mrsenknt
+	unsigned DftMax = 4096;     // a DFT O(n^2): 32768-as ablakon hvsonknt msodpercekig tart
+	unsigned Threads = 0;       // a teljes lnc szlkszlete; 0: a hardver ltal tmogatott szlak szma
+	std::vector<std::string> Stages; // res: mind
+	std::string OutputPath;     // res: szabvnyos kimenet
+	std::string TempDirectory;
+};
+
+// Egy mrs eredmnye; az idk egy hvsra vonatkoznak, nanoszekundumban.
+struct Measurement
+{
+	std::string Stage;
+	std::vector<std::pair<std::string, std::string>> Params; // nv s ksz JSON-rtk
+	size_t Reps = 0;
+	size_t Iterations = 0; // hvs mintnknt
+	double Mean = 0.0;
+	double Median = 0.0;
+	double Min = 0.0;
+	double Max = 0.0;
+	double StdDev = 0.0;
+	double Items = 0.0;    // egy hvs ltal feldolgozott elemek szma (az tviteli sebessghez)
+	std::string ItemUnit;
+};
+
+using Params = std::vector<std::pair<std::string, std::string>>;
+
+static const double MinSampleSeconds = 1e-4;
+static const size_t MaxReps = 100000;
+static const unsigned SampleRate = 44100;
+
+// Az optimalizl ne hagyhassa el a mrt hvsok eredmnyt.
+static volatile double sink = 0.0;
+
+static std::string FormatNumber(const double value)
+{
+	if (!std::isfinite(value))
+		return "null";
+	std::ostringstream out;
+	out.precision(6);
+	out << value;
+	return out.str();
+}
+
+static std::string Quote(const std::string& text)
+{
+	std::string quoted = "\"";
+	for (const char c : text)
+	{
+		if (c == '"' || c == '\\')
+			quoted += '\\';
+		quoted += c;
+	}
+	return quoted + "\"";
+}
+
+template <typename Function>
+static Measurement Measure(const BenchSettings& settings, const std::string& stage, const Params& params,
+	const double items, const std::string& unit, Function run)
+{
+	Measurement m;
+	m.Stage = stage;
+	m.Params = params;
+	m.Items = items;
+	m.ItemUnit = unit;
+
+	// Bemelegts (gyorsttrak, tervek, lapok); a leggyorsabb futsbl addik a mintnknti hvsszm.
+	double fastest = std::numeric_limits<double>::max();
+	for (unsigned i = 0; i < std::max(settings.Warmup, 1u); i++)
+	{
+		const Clock::time_point start = Clock::now();
+		run();
+		fastest = std::min(fastest, std::chrono::duration<double>(Clock::now() - start).count());
+	}
+	m.Iterations = fastest < MinSampleSeconds ? static_cast<size_t>(std::ceil(MinSampleSeconds / std::max(fastest, 1e-9))) : 1;
+
+	std::vector<double> samples;
+	const Clock::time_point begin = Clock::now();
+	while (samples.size() < settings.MinReps ||
+		(samples.size() < MaxReps && std::chrono::duration<double>(Clock::now() - begin).count() < settings.MinTime))
+	{
+		const Clock::time_point start = Clock::now();
+		for (size_t i = 0; i < m.Iterations; i++)
+			run();
+		samples.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count() / m.Iterations);
+	}
+
+	m.Reps = samples.size();
+	double sum = 0.0;
+	for (const double sample : samples)
+		sum += sample;
+	m.Mean = sum / m.Reps;
+	double variance = 0.0;
+	for (const double sample : samples)
+		variance += (sample - m.Mean) * (sample - m.Mean);
+	m.StdDev = m.Reps > 1 ? std::sqrt(variance / (m.Reps - 1)) : 0.0;
+
+	std::sort(samples.begin(), samples.end());
+	m.Min = samples.front();
+	m.Max = samples.back();
+	m.Median = m.Reps % 2 ? samples[m.Reps / 2] : 0.5 * (samples[m.Reps / 2 - 1] + samples[m.Reps / 2]);
+
+	std::cerr << "  " << stage;
+	for (const auto& param : params)
+		std::cerr << " " << param.first << "=" << param.second;
+	std::cerr << ": median " << m.Median / 1000.0 << " us, " << m.Reps << " x " << m.Iterations << std::endl;
+	return m;
+}
+
+static std::string Param(const unsigned value)
+{
+	return std::to_string(value);
+}
+
+static std::string Param(const std::string& value)
+{
+	return Quote(value);
+}
+
+// C-dr hrmashangzat (C4, E4, G4) csatornnknt kiss eltr erssggel, tlapolva
+static void Synthesize(const size_t first, const size_t frames, const unsigned channels, float* interleaved)
+{
+	static const double Pitches[] = { 261.63, 329.63, 392.00 };
+	const double PI2 = 2.0 * 3.14159265358979323846;
+	for (size_t i = 0; i < frames; i++)
+	{
+		const double t = static_cast<double>(first + i) / SampleRate;
+		double value = 0.0;
+		for (const double pitch : Pitches)
+			value += 0.25 * std::sin(PI2 * pitch * t);
+		for (unsigned c = 0; c < channels; c++)
+			interleaved[i * channels + c] = static_cast<float>(value * (1.0 - 0.1 * c / channels));
+	}
+}
+
+static std::vector<float> Synthesize(const double seconds, const unsigned channels)
+{
+	std::vector<float> interleaved(static_cast<size_t>(seconds * SampleRate) * channels);
+	Synthesize(0, interleaved.size() / channels, channels, interleaved.data());
+	return interleaved;
+}
+
+static unsigned long CurrentProcessId()
+{
+#if defined(_WIN32)
+	return static_cast<unsigned long>(_getpid());
+#else
+	return static_cast<unsigned long>(getpid());
+#endif
+}
+
+// A mrs vgn trlend, generlt hangfjlok. A nevkben a folyamat azonostja is szerepel, gy a
+// kzs ideiglenes knyvtrban prhuzamosan fut mrsek nem rjk fell (s nem trlik) egyms fjljait.
+class TempFiles
+{
+public:
+	explicit TempFiles(const std::string& directory) : directory(directory) {}
+	~TempFiles()
+	{
+		for (const std::string& path : paths)
+			std::remove(path.c_str());
+	}
+
+	TempFiles(const TempFiles&) = delete;
+	TempFiles& operator=(const TempFiles&) = delete;
+
+	// 16 bites WAV vagy FLAC fjl a szintetikus jellel; sikertelen rsnl kivtelt dob.
+	std::string Create(const std::string& format, const unsigned seconds, const unsigned channels)
+	{
+		const std::string path = directory + "/tonelyzer_bench_" + std::to_string(CurrentProcessId()) + "_" + std::to_string(seconds) + "s_" + std::to_string(channels) + "ch." + format;
+
+		SF_INFO info = {};
+		info.samplerate = SampleRate;
+		info.channels = channels;
+		info.format = (format == "flac" ? SF_FORMAT_FLAC : SF_FORMAT_WAV) | SF_FORMAT_PCM_16;
+		SNDFILE* file = sf_open(path.c_str(), SFM_WRITE, &info);
+		if (!file)
+			throw std::runtime_error("Cannot create " + path + ": " + sf_strerror(nullptr));
+		paths.push_back(path);
+
+		const size_t frames = static_cast<size_t>(seconds) * SampleRate;
+		const size_t block = 65536;
+		std::vector<float> interleaved(block * channels);
+		for (size_t first = 0; first < frames; first += block)
+		{
+			const size_t count = std::min(block, frames - first);
+			Synthesize(first, count, channels, interleaved.data());
+			if (sf_writef_float(file, interleaved.data(), count) != static_cast<sf_count_t>(count))
+			{
+				sf_close(file);
+				throw std::runtime_error("Cannot write " + path + ": " + sf_strerror(nullptr));
+			}
+		}
+		sf_close(file);
+		return path;
+	}
+
+private:
+	std::string directory;
+	std::vector<std::string> paths;
+};
+
+// Transformer::FFT s DFT a leglis ablakmreteken (128 - 32768, a DFT -dftmax-ig)
+static void BenchTransforms(const BenchSettings& settings, const bool dft, std::vector<Measurement>& results)
+{
+	const std::vector<float> signal = Synthesize(1.0, 1);
+	BufferSource source(signal.data(), signal.size(), SampleRate, 1);
+	for (unsigned size = 128; size <= (dft ? std::min(settings.DftMax, 32768u) : 32768u); size *= 2)
+	{
+		Transformer transformer(source, size); // a Transformer a sajt ablakmretnek tervt tartja meg
+		FTdata window(size), result(size);
+		for (unsigned i = 0; i < size; i++)
+			window[i] = signal[i % signal.size()];
+
+		results.push_back(Measure(settings, dft ? "dft" : "fft", { { "window", Param(size) } }, size, "samples", [&]()
+		{
+			if (dft)
+				transformer.DFT(window, result);
+			else
+				transformer.FFT(window, result);
+			sink = sink + result[1].real();
+		}));
+	}
+}
+
+// Reader::ReadAudio WAV s FLAC fjlokra, klnbz hosszal s csatornaszmmal
+static void BenchRead(const BenchSettings& settings, TempFiles& files, std::vector<Measurement>& results)
+{
+	for (const std::string format : { "wav", "flac" })
+		for (const unsigned seconds : { 10u, 60u })
+			for (const unsigned channels : { 1u, 2u, 6u })
+			{
+				const std::string path = files.Create(format, seconds, channels);
+				results.push_back(Measure(settings, "read", { { "format", Param(format) }, { "seconds", Param(seconds) }, { "channels", Param(channels) } },
+					static_cast<double>(seconds) * SampleRate, "frames", [&]()
+				{
+					const AudioData data = Reader::ReadAudio(path);
+					sink = sink + data.MonoData.size();
+				}));
+			}
+}
+
+// PitchAnalyzer::CalculateHistogram mdonknt s ablakmretenknt; a spektrum 10 msodpercnyi jelbl kszl.
+// DFT mdban a spektrum alakja s gy a hisztogram kltsge az FFT-vel azonos.
+static void BenchHistogram(const BenchSettings& settings, const std::shared_ptr<ThreadPool>& pool, std::vector<Measurement>& results)
+{
+	struct Variant { FTmode Mode; unsigned BinsPerSemitone; };
+	const std::vector<float> signal = Synthesize(10.0, 1);
+	for (const Variant variant : { Variant{ FTmode::FFT, 1 }, Variant{ FTmode::GOERTZEL, 1 }, Variant{ FTmode::CQT, 1 }, Variant{ FTmode::CQT, 3 } })
+		for (const unsigned size : { 4096u, 16384u })
+		{
+			BufferSource source(signal.data(), signal.size(), SampleRate, 1);
+			Transformer transformer(source, size);
+			transformer.SetThreadPool(pool);
+			transformer.SetBinsPerSemitone(variant.BinsPerSemitone);
+			transformer.SetVerbose(false);
+			const Spectrum spectrum = transformer.AvgFourier(variant.Mode);
+			const PitchAnalyzer analyzer(spectrum);
+
+			results.push_back(Measure(settings, "histogram", { { "mode", Param(GetFTmodeName(variant.Mode)) }, { "bps", Param(variant.BinsPerSemitone) }, { "window", Param(size) } },
+				static_cast<double>(spectrum.Bins.size()), "bins", [&]()
+			{
+				const PitchHistogram histogram = analyzer.CalculateHistogram(440.0f);
+				sink = sink + histogram[0];
+			}));
+		}
+}
+
+// Transformer::AvgFourier egy szlon, 60 msodpercnyi mon jelen, msodpercnyi hanganyagra vettve: a CQT
+// md a szoksos ablakmretekkel s a 32768-as ablak FFT, amelyhez a felbontsa mrhet.
+static void BenchTransform(const BenchSettings& settings, std::vector<Measurement>& results)
+{
+	struct Variant { FTmode Mode; unsigned BinsPerSemitone; unsigned WindowSize; };
+	const double seconds = 60.0;
+	const std::vector<float> signal = Synthesize(seconds, 1);
+	for (const Variant variant : { Variant{ FTmode::FFT, 1, 32768 }, Variant{ FTmode::CQT, 1, 2048 }, Variant{ FTmode::CQT, 1, 4096 }, Variant{ FTmode::CQT, 3, 4096 } })
+	{
+		results.push_back(Measure(settings, "transform", { { "mode", Param(GetFTmodeName(variant.Mode)) }, { "bps", Param(variant.BinsPerSemitone) }, { "window", Param(variant.WindowSize) } },
+			seconds, "seconds", [&]()
+		{
+			BufferSource source(signal.data(), signal.size(), SampleRate, 1);
+			Transformer transformer(source, variant.WindowSize);
+			transformer.SetBinsPerSemitone(variant.BinsPerSemitone);
+			transformer.SetVerbose(false);
+			const Spectrum spectrum = transformer.AvgFourier(variant.Mode);
+			sink = sink + spectrum.Bins[0].real();
+		}));
+	}
+}
+
+// PitchAnalyzer::CalculateKeyKrumhansl, valamint az sszes profilcsald egyttes pontozsa (CalculateKeys)
+static void BenchKeys(const BenchSettings& settings, std::vector<Measurement>& results)
+{
+	const Spectrum empty;
+	PitchAnalyzer analyzer(empty);
+	const PitchHistogram histogram = { 6.35f, 2.23f, 3.48f, 2.33f, 4.38f, 4.09f, 2.52f, 5.19f, 2.39f, 3.66f, 2.29f, 2.88f };
+
+	results.push_back(Measure(settings, "krumhansl", {}, 24.0, "keys", [&]()
+	{
+		const KeyPair key = analyzer.CalculateKeyKrumhansl(histogram);
+		sink = sink + key.first;
+	}));
+
+	analyzer.SetProfiles(ParseProfiles("all"));
+	results.push_back(Measure(settings, "keys", { { "profiles", Param(std::string("all")) } }, 24.0, "keys", [&]()
+	{
+		const KeyAnalysis keys = analyzer.CalculateKeys(histogram);
+		sink = sink + keys.Ensemble.Score;
+	}));
+}
+
+// A teljes lnc (dekdols, lekevers, transzformci, hisztogram, pontozs) egy 60 msodperces
+// sztere fjlon, valamint ugyanez memribl, dekdols nlkl
+static void BenchPipeline(const BenchSettings& settings, TempFiles& files, std::vector<Measurement>& results)
+{
+	struct Variant { FTmode Mode; bool Decimate; };
+	const unsigned seconds = 60, channels = 2;
+	const std::string wav = files.Create("wav", seconds, channels);
+	const std::string flac = files.Create("flac", seconds, channels);
+	const std::vector<float> signal = Synthesize(seconds, channels);
+	const double frames = static_cast<double>(seconds) * SampleRate;
+
+	for (const Variant variant : { Variant{ FTmode::FFT, false }, Variant{ FTmode::FFT, true }, Variant{ FTmode::GOERTZEL, false }, Variant{ FTmode::CQT, false } })
+	{
+		InitData init;
+		init.FourierMode = variant.Mode;
+		init.Input.Decimate = variant.Decimate;
+		init.ThreadCount = settings.Threads;
+		const AnalyzerContext context(init);
+
+		for (const std::string input : { "wav", "flac", "memory" })
+		{
+			const Params params = { { "input", Param(input) }, { "mode", Param(GetFTmodeName(variant.Mode)) },
+				{ "decimate", variant.Decimate ? "true" : "false" }, { "window", Param(init.FTWindowSize) }, { "threads", Param(context.GetThreadCount()) } };
+			results.push_back(Measure(settings, "pipeline", params, frames, "frames", [&]()
+			{
+				const FileResult result = input == "memory" ? context.Analyze(signal.data(), signal.size() / channels, SampleRate, channels)
+					: context.AnalyzeFile(input == "wav" ? wav : flac);
+				sink = sink + result.Keys.Ensemble.Score;
+			}));
+		}
+	}
+}
+
+static std::string GetTimestamp()
+{
+	const std::time_t now = std::time(nullptr);
+	char text[32];
+	std::strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+	return text;
+}
+
+static std::string GetCompiler()
+{
+#if defined(__clang__)
+	return "clang " __clang_version__;
+#elif defined(__GNUC__)
+	return "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+	return "msvc " + std::to_string(_MSC_VER);
+#else
+	return "unknown";
+#endif
+}
+
+static void WriteJson(std::ostream& out, const BenchSettings& settings, const std::vector<Measurement>& results)
+{
+	const CpuFeatures& cpu = GetCpuFeatures();
+	out << "{\n";
+	out << "  \"benchmark\": \"tonelyzer\",\n";
+	out << "  \"timestamp\": " << Quote(GetTimestamp()) << ",\n";
+	out << "  \"system\": { \"hardware_threads\": " << ThreadPool::GetDefaultThreadCount() << ", \"avx2\": " << (cpu.AVX2 && cpu.FMA ? "true" : "false")
+		<< ", \"compiler\": " << Quote(GetCompiler()) <<
+#if defined(NDEBUG)
+		", \"build\": \"release\" },\n";
+#else
+		", \"build\": \"debug\" },\n";
+#endif
+	out << "  \"settings\": { \"warmup\": " << std::max(settings.Warmup, 1u) << ", \"min_reps\": " << settings.MinReps << ", \"min_time\": " << FormatNumber(settings.MinTime)
+		<< ", \"sample_rate\": " << SampleRate << " },\n";
+	out << "  \"results\": [";
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const Measurement& m = results[i];
+		out << (i ? ",\n" : "\n") << "    { \"stage\": " << Quote(m.Stage) << ", \"params\": {";
+		for (size_t p = 0; p < m.Params.size(); p++)
+			out << (p ? ", " : " ") << Quote(m.Params[p].first) << ": " << m.Params[p].second;
+		out << (m.Params.empty() ? "}" : " }");
+		out << ", \"reps\": " << m.Reps << ", \"iterations\": " << m.Iterations;
+		out << ", \"mean_ns\": " << FormatNumber(m.Mean) << ", \"median_ns\": " << FormatNumber(m.Median) << ", \"min_ns\": " << FormatNumber(m.Min)
+			<< ", \"max_ns\": " << FormatNumber(m.Max) << ", \"stddev_ns\": " << FormatNumber(m.StdDev);
+		out << ", \"throughput\": " << FormatNumber(m.Items / m.Median * 1e9) << ", \"throughput_unit\": " << Quote(m.ItemUnit + "/s") << " }";
+	}
+	out << "\n  ]\n}\n";
+}
+
+static std::string GetDefaultTempDirectory()
+{
+	for (const char* name : { "TMPDIR", "TEMP", "TMP" })
+	{
+		const char* value = std::getenv(name);
+		if (value && *value)
+			return value;
+	}
+	return ".";
+}
+
+static bool ParseArguments(int argc, char* argv[], BenchSettings& settings)
+{
+	settings.TempDirectory = GetDefaultTempDirectory();
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string arg = argv[i];
+		const size_t equals = arg.find('=');
+		const std::string name = arg.substr(0, equals);
+		const std::string value = equals == std::string::npos ? "" : arg.substr(equals + 1);
+		try
+		{
+			if (name == "-warmup")
+				settings.Warmup = std::stoul(value);
+			else if (name == "-reps")
+				settings.MinReps = std::max(1ul, std::stoul(value));
+			else if (name == "-time")
+				settings.MinTime = std::stod(value);
+			else if (name == "-dftmax")
+				settings.DftMax = std::stoul(value);
+			else if (name == "-j")
+				settings.Threads = std::stoul(value);
+			else if (name == "-tmp")
+				settings.TempDirectory = value;
+			else if (name == "-o")
+				settings.OutputPath = value;
+			else if (name == "-stages")
+			{
+				std::istringstream list(value);
+				std::string stage;
+				while (std::getline(list, stage, ','))
+				{
+					static const std::vector<std::string> Known = { "fft", "dft", "read", "transform", "histogram", "krumhansl", "pipeline" };
+					if (std::find(Known.begin(), Known.end(), stage) == Known.end())
+					{
+						std::cerr << "Unknown stage: " << stage << std::endl;
+						return false;
+					}
+					settings.Stages.push_back(stage);
+				}
+			}
+			else
+			{
+				std::cerr << "Unknown argument: " << arg << std::endl;
+				return false;
+			}
+		}
+		catch (const std::exception&)
+		{
+			std::cerr << "Invalid value: " << arg << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	BenchSettings settings;
+	if (!ParseArguments(argc, argv, settings))
+	{
+		std::cerr << "Tonelyzer benchmark syntax: <executable_name> [-stages=fft,dft,read,transform,histogram,krumhansl,pipeline] [-warmup=2] [-reps=5] [-time=0.3] [-dftmax=4096] [-j=N] [-tmp=dir] [-o=results.json]" << std::endl;
+		return 1;
+	}
+
+	const auto enabled = [&](const std::string& stage)
+	{
+		return settings.Stages.empty() || std::find(settings.Stages.begin(), settings.Stages.end(), stage) != settings.Stages.end();
+	};
+
+	std::vector<Measurement> results;
+	try
+	{
+		TempFiles files(settings.TempDirectory);
+		const std::shared_ptr<ThreadPool> pool = std::make_shared<ThreadPool>(settings.Threads);
+
+		if (enabled("fft"))
+			BenchTransforms(settings, false, results);
+		if (enabled("dft"))
+			BenchTransforms(settings, true, results);
+		if (enabled("read"))
+			BenchRead(settings, files, results);
+		if (enabled("transform"))
+			BenchTransform(settings, results);
+		if (enabled("histogram"))
+			BenchHistogram(settings, pool, results);
+		if (enabled("krumhansl"))
+			BenchKeys(settings, results);
+		if (enabled("pipeline"))
+			BenchPipeline(settings, files, results);
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+
+	if (settings.OutputPath.empty())
+		WriteJson(std::cout, settings, results);
+	else
+	{
+		std::ofstream out(settings.OutputPath);
+		WriteJson(out, settings, results);
+		if (!out)
+		{
+			std::cerr << "Cannot write " << settings.OutputPath << std::endl;
+			return 1;
+		}
+	}
+	return 0;
+}
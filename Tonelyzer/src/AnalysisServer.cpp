@@ -0,0 +1,472 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <thread>
+
+#include "AnalysisServer.h"
+#include "BatchAnalyzer.h"
+#include "BufferSource.h"
+#include "ChromaMap.h"
+#include "FFTPlan.h"
+#include "PitchAnalyzer.h"
+#include "WindowFunction.h"
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <winsock2.h>
+#include <afunix.h>
+#pragma comment(lib, "Ws2_32.lib")
+using SocketHandle = SOCKET;
+static const SocketHandle InvalidSocket = INVALID_SOCKET;
+static void CloseSocket(const SocketHandle socket) { closesocket(socket); }
+#else
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+using SocketHandle = int;
+static const SocketHandle InvalidSocket = -1;
+static void CloseSocket(const SocketHandle socket) { close(socket); }
+#endif
+
+// Egy PCM krs adatblokkjnak fels korltja
+static const size_t MaxPayloadBytes = static_cast<size_t>(1) << 30;
+
+struct AnalysisServer::Connection
+{
+	SocketHandle Socket;
+	std::mutex WriteMutex;
+	std::mutex RequestMutex;
+	std::map<std::string, std::shared_ptr<std::atomic<bool>>> Requests; // a vrakoz s fut krsek megszakts-jelzi
+
+	explicit Connection(const SocketHandle socket) : Socket(socket) {}
+	~Connection() { CloseSocket(Socket); }
+
+	// Egy vlaszsor elkldse egszben (a prhuzamos vlaszok nem keveredhetnek); bontott kapcsolatnl elvsz.
+	void Send(const std::string& line)
+	{
+		const std::string data = line + "\n";
+		std::lock_guard<std::mutex> lock(WriteMutex);
+		size_t sent = 0;
+		while (sent < data.size())
+		{
+			const auto n = send(Socket, data.data() + sent, static_cast<int>(data.size() - sent), 0);
+			if (n <= 0)
+				return;
+			sent += static_cast<size_t>(n);
+		}
+	}
+
+	// Legfeljebb size bjt fogadsa; 0 a kapcsolat vgt (vagy hibt) jelzi.
+	size_t Receive(char* buffer, const size_t size)
+	{
+		const auto n = recv(Socket, buffer, static_cast<int>(size), 0);
+		return n > 0 ? static_cast<size_t>(n) : 0;
+	}
+};
+
+// JSON karakterlnc-literl belseje
+static std::string EscapeJson(const std::string& text)
+{
+	std::string escaped;
+	for (const char c : text)
+	{
+		if (c == '"' || c == '\\')
+			escaped += std::string("\\") + c;
+		else if (static_cast<unsigned char>(c) < 0x20)
+		{
+			char code[8];
+			std::snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned>(c));
+			escaped += code;
+		}
+		else
+			escaped += c;
+	}
+	return escaped;
+}
+
+// Nma bemenetnl a korrelci NaN lehet, ami nem rvnyes JSON szm.
+static std::string FormatNumber(const double value)
+{
+	if (!std::isfinite(value))
+		return "null";
+	std::ostringstream out;
+	out << value;
+	return out.str();
+}
+
+AnalysisServer::AnalysisServer(const InitData& init)
+	: init(init)
+{
+	// A krsek a munkaszlakon futnak (senki sem hv Wait-et), ezrt legalbb egy munkaszl kell.
+	const unsigned threads = init.ThreadCount == 0 ? ThreadPool::GetDefaultThreadCount() : init.ThreadCount;
+	pool = std::make_shared<ThreadPool>(std::max(2u, threads));
+
+	if (!init.CachePath.empty())
+	{
+		try
+		{
+			cache.reset(new ResultCache(init.CachePath));
+		}
+		catch (const std::exception& e)
+		{
+			std::cerr << e.what() << ", continuing without the cache." << std::endl;
+		}
+	}
+}
+
+// Az alaprtelmezett belltsok FFT-terve, ablaktblja s hangosztly-lekpezsei mr az els
+// krs eltt elkszlnek.
+void AnalysisServer::Warm()
+{
+	const unsigned windowSize = init.FTWindowSize;
+	if (windowSize < 2 || (windowSize & (windowSize - 1)) != 0)
+		return;
+
+	RealFFTPlan::Get(windowSize);
+	WindowFunction::Get(init.Window, windowSize);
+	for (const unsigned sampleRate : { 44100u, 48000u })
+		ChromaMap::Get(sampleRate, windowSize, init.ReferencePitch);
+}
+
+int AnalysisServer::Run()
+{
+#if defined(_WIN32)
+	WSADATA data;
+	if (WSAStartup(MAKEWORD(2, 2), &data) != 0)
+	{
+		std::cerr << "Cannot initialize Winsock" << std::endl;
+		return 1;
+	}
+#else
+	std::signal(SIGPIPE, SIG_IGN); // a bontott kapcsolatba rs ne lltsa le a folyamatot
+#endif
+
+	sockaddr_un address;
+	std::memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (init.ServePath.size() >= sizeof(address.sun_path))
+	{
+		std::cerr << "Socket path is too long: " << init.ServePath << std::endl;
+		return 1;
+	}
+	std::memcpy(address.sun_path, init.ServePath.c_str(), init.ServePath.size());
+
+	// Egy korbbi futs itt maradt socketjnek eltvoltsa (ms fjlt nem trlnk).
+#if defined(_WIN32)
+	DeleteFileA(init.ServePath.c_str());
+#else
+	struct stat info;
+	if (stat(init.ServePath.c_str(), &info) == 0 && S_ISSOCK(info.st_mode))
+		unlink(init.ServePath.c_str());
+#endif
+
+	const SocketHandle listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listener == InvalidSocket)
+	{
+		std::cerr << "Cannot create socket" << std::endl;
+		return 1;
+	}
+
+	if (bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, SOMAXCONN) != 0)
+	{
+		std::cerr << "Cannot listen on " << init.ServePath << std::endl;
+		CloseSocket(listener);
+		return 1;
+	}
+
+	Warm();
+	std::cout << "Tonelyzer: Listening on " << init.ServePath << " with " << pool->GetThreadCount() << " thread(s)" << std::endl;
+
+	// Kapcsolatonknt egy olvas szl; az elemzsek a kzs szlkszleten futnak.
+	while (true)
+	{
+		const SocketHandle client = accept(listener, nullptr, nullptr);
+		if (client == InvalidSocket)
+		{
+			std::cerr << "Cannot accept connections on " << init.ServePath << std::endl;
+			CloseSocket(listener);
+			return 1;
+		}
+
+		std::thread(&AnalysisServer::Serve, this, std::make_shared<Connection>(client)).detach();
+	}
+}
+
+void AnalysisServer::Serve(std::shared_ptr<Connection> connection)
+{
+	std::string buffer;
+	std::vector<char> chunk(1 << 16);
+
+	// Kevesebb, mint bytes bjt van a pufferben: olvass, amg a kapcsolat l
+	auto fill = [&](const size_t bytes)
+	{
+		while (buffer.size() < bytes)
+		{
+			const size_t received = connection->Receive(chunk.data(), chunk.size());
+			if (received == 0)
+				return false;
+			buffer.append(chunk.data(), received);
+		}
+		return true;
+	};
+
+	while (true)
+	{
+		size_t end;
+		while ((end = buffer.find('\n')) == std::string::npos)
+			if (!fill(buffer.size() + 1))
+				break;
+		if (end == std::string::npos)
+			break;
+
+		std::string line = buffer.substr(0, end);
+		buffer.erase(0, end + 1);
+		if (!line.empty() && line.back() == '\r')
+			line.pop_back();
+
+		const std::vector<std::string> tokens = Tokenize(line);
+		if (tokens.empty())
+			continue;
+
+		// PCM krsnl a sort az tlapolt mintkat tartalmaz adatblokk kveti.
+		std::shared_ptr<std::vector<char>> payload = std::make_shared<std::vector<char>>();
+		if (tokens.size() >= 6 && tokens[1] == "pcm")
+		{
+			const size_t bytes = static_cast<size_t>(std::strtoull(tokens[5].c_str(), nullptr, 10));
+			if (bytes > MaxPayloadBytes)
+			{
+				// Az adatblokkot nem olvassuk be, gy a folyam nem szinkronizlhat jra: a kapcsolat bezrul.
+				connection->Send(FormatStatus(tokens[0], "error", "PCM payload is too large"));
+				break;
+			}
+			if (!fill(bytes))
+				break;
+			payload->assign(buffer.begin(), buffer.begin() + bytes);
+			buffer.erase(0, bytes);
+		}
+
+		Dispatch(connection, tokens, payload);
+	}
+
+	// A bontott kapcsolat krsei feleslegesek.
+	std::lock_guard<std::mutex> lock(connection->RequestMutex);
+	for (auto& request : connection->Requests)
+		*request.second = true;
+}
+
+void AnalysisServer::Dispatch(const std::shared_ptr<Connection>& connection, const std::vector<std::string>& tokens, std::shared_ptr<std::vector<char>> payload)
+{
+	const std::string& id = tokens[0];
+	const std::string command = tokens.size() > 1 ? tokens[1] : std::string();
+
+	if (command == "ping")
+	{
+		connection->Send(FormatStatus(id, "ok"));
+		return;
+	}
+
+	if (command == "cancel")
+	{
+		bool found = false;
+		{
+			std::lock_guard<std::mutex> lock(connection->RequestMutex);
+			const auto request = connection->Requests.find(tokens.size() > 2 ? tokens[2] : std::string());
+			if (request != connection->Requests.end())
+			{
+				*request->second = true;
+				found = true;
+			}
+		}
+		connection->Send(found ? FormatStatus(id, "ok") : FormatStatus(id, "error", "No such pending request"));
+		return;
+	}
+
+	if (command != "analyze" && command != "pcm")
+	{
+		connection->Send(FormatStatus(id, "error", "Unknown command '" + command + "'"));
+		return;
+	}
+
+	std::shared_ptr<std::atomic<bool>> cancel = std::make_shared<std::atomic<bool>>(false);
+	{
+		std::lock_guard<std::mutex> lock(connection->RequestMutex);
+		if (!connection->Requests.emplace(id, cancel).second)
+			cancel.reset();
+	}
+	if (!cancel)
+	{
+		connection->Send(FormatStatus(id, "error", "Duplicate request id"));
+		return;
+	}
+
+	pool->Submit([this, connection, tokens, payload, cancel]()
+	{
+		const std::string response = Execute(tokens[0], tokens, *payload, *cancel);
+		{
+			std::lock_guard<std::mutex> lock(connection->RequestMutex);
+			connection->Requests.erase(tokens[0]);
+		}
+		connection->Send(response);
+	});
+}
+
+std::string AnalysisServer::Execute(const std::string& id, const std::vector<std::string>& tokens, const std::vector<char>& payload, const std::atomic<bool>& cancel)
+{
+	if (cancel)
+		return FormatStatus(id, "cancelled");
+
+	const auto before = std::chrono::high_resolution_clock::now();
+	try
+	{
+		FileResult result;
+		bool cached = false;
+
+		if (tokens[1] == "analyze")
+		{
+			const InitData request = ParseOptions(std::vector<std::string>(tokens.begin() + 2, tokens.end()));
+			if (request.Inputs.size() != 1)
+				return FormatStatus(id, "error", "Expected: <id> analyze <path> [options]");
+
+			const std::string& path = request.Inputs[0];
+			FileIdentity identity;
+			const bool identified = (cache || request.SpectrumSidecar) && ResultCache::GetFileIdentity(path, identity);
+			const uint64_t parameterHash = ResultCache::GetParameterHash(request);
+
+			result.Path = path;
+			cached = identified && cache && cache->Find(identity, parameterHash, result);
+			if (!cached)
+			{
+				result = BatchAnalyzer::Analyze(path, request, pool, identified ? &identity : nullptr, &cancel);
+				if (identified && cache)
+					cache->Store(identity, parameterHash, result);
+			}
+		}
+		else
+		{
+			if (tokens.size() < 6)
+				return FormatStatus(id, "error", "Expected: <id> pcm <rate> <channels> <f32|s16> <bytes> [options]");
+
+			const unsigned sampleRate = static_cast<unsigned>(std::atoi(tokens[2].c_str()));
+			const unsigned channels = static_cast<unsigned>(std::atoi(tokens[3].c_str()));
+			const std::string& format = tokens[4];
+			const InitData request = ParseOptions(std::vector<std::string>(tokens.begin() + 6, tokens.end()));
+			if (channels == 0)
+				return FormatStatus(id, "error", "Invalid channel count");
+
+			// A socketrl rkez blokk nem felttlenl igaztott, ezrt a mintk tmsoldnak.
+			std::unique_ptr<BufferSource> source;
+			if (format == "f32")
+			{
+				std::vector<float> samples(payload.size() / (sizeof(float) * channels) * channels);
+				std::memcpy(samples.data(), payload.data(), samples.size() * sizeof(float));
+				source.reset(new BufferSource(samples.data(), samples.size() / channels, sampleRate, channels, request.Input, id));
+			}
+			else if (format == "s16")
+			{
+				std::vector<int16_t> samples(payload.size() / (sizeof(int16_t) * channels) * channels);
+				std::memcpy(samples.data(), payload.data(), samples.size() * sizeof(int16_t));
+				source.reset(new BufferSource(samples.data(), samples.size() / channels, sampleRate, channels, request.Input, id));
+			}
+			else
+				return FormatStatus(id, "error", "Unknown sample format '" + format + "'");
+
+			result = BatchAnalyzer::Analyze(*source, request, pool, &cancel);
+		}
+
+		const auto after = std::chrono::high_resolution_clock::now();
+		const double milliseconds = std::chrono::duration_cast<std::chrono::microseconds>(after - before).count() / 1000.0;
+		return FormatResult(id, result, cached, milliseconds);
+	}
+	catch (const AnalysisCancelled&)
+	{
+		return FormatStatus(id, "cancelled");
+	}
+	catch (const std::exception& e)
+	{
+		return FormatStatus(id, "error", e.what());
+	}
+}
+
+// Szkzzel elvlasztott szavak; idzjelek kztt a szkz is a sz rsze.
+std::vector<std::string> AnalysisServer::Tokenize(const std::string& line)
+{
+	std::vector<std::string> tokens;
+	std::string current;
+	bool quoted = false, inToken = false;
+	for (const char c : line)
+	{
+		if (c == '"')
+		{
+			quoted = !quoted;
+			inToken = true;
+		}
+		else if ((c == ' ' || c == '\t') && !quoted)
+		{
+			if (inToken)
+				tokens.push_back(current);
+			current.clear();
+			inToken = false;
+		}
+		else
+		{
+			current += c;
+			inToken = true;
+		}
+	}
+	if (inToken)
+		tokens.push_back(current);
+	return tokens;
+}
+
+// A krs kapcsoli a parancssoriakkal azonos mdon rtelmezdnek; a gyorsttrak a kiszolgl.
+InitData AnalysisServer::ParseOptions(const std::vector<std::string>& options) const
+{
+	std::vector<char*> argv;
+	argv.push_back(const_cast<char*>("tonelyzer"));
+	for (const std::string& option : options)
+		argv.push_back(const_cast<char*>(option.c_str()));
+
+	InitData request = GetInitData(static_cast<int>(argv.size()), argv.data());
+	request.CachePath = init.CachePath;
+	request.SpectrumSidecar = init.SpectrumSidecar;
+	request.SidecarDirectory = init.SidecarDirectory;
+	request.ServePath.clear();
+	return request;
+}
+
+std::string AnalysisServer::FormatStatus(const std::string& id, const std::string& status, const std::string& message)
+{
+	std::string response = "{\"id\":\"" + EscapeJson(id) + "\",\"status\":\"" + status + "\"";
+	if (!message.empty())
+		response += ",\"message\":\"" + EscapeJson(message) + "\"";
+	return response + "}";
+}
+
+std::string AnalysisServer::FormatResult(const std::string& id, const FileResult& result, const bool cached, const double milliseconds)
+{
+	std::ostringstream out;
+	out << "{\"id\":\"" << EscapeJson(id) << "\",\"status\":\"ok\"";
+	out << ",\"key\":\"" << PitchAnalyzer::GetKeyName(result.Keys.Ensemble.Key) << "\"";
+	out << ",\"score\":" << FormatNumber(result.Keys.Ensemble.Score);
+	out << ",\"reference\":" << FormatNumber(result.ReferencePitch);
+
+	out << ",\"histogram\":[";
+	for (size_t i = 0; i < result.Histogram.size(); i++)
+		out << (i > 0 ? "," : "") << FormatNumber(result.Histogram[i]);
+	out << "]";
+
+	out << ",\"families\":[";
+	for (size_t i = 0; i < result.Keys.Families.size(); i++)
+	{
+		const KeyEstimate& estimate = result.Keys.Families[i];
+		out << (i > 0 ? "," : "") << "{\"profile\":\"" << EscapeJson(estimate.Profile) << "\",\"key\":\"" << PitchAnalyzer::GetKeyName(estimate.Key)
+			<< "\",\"score\":" << FormatNumber(estimate.Score) << "}";
+	}
+	out << "]";
+
+	out << ",\"cached\":" << (cached ? "true" : "false") << ",\"ms\":" << FormatNumber(milliseconds) << "}";
+	return out.str();
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+#include "Structures.h"
+#include "ThreadPool.h"
+#include "ResultCache.h"
+
+// Hosszan fut elemz kiszolgl egy helyi (Unix domain) socketen (-serve=tvonal). A szlkszlet,
+// az FFT-tervek, ablaktblk s hangosztly-lekpezsek (a ::Get gyorsttrak), valamint a
+// -cache gyorsttr a krsek kztt melegen maradnak, gy egy rvid rszlet elemzse lnyegben
+// csak a transzformci idejbe kerl.
+// Protokoll: soronknt egy krs, "<azonost> <parancs> [argumentumok]" alakban (szkzt tartalmaz
+// tvonal idzjelek kzt adhat meg):
+//   <id> analyze <tvonal> [kapcsolk]               egy fjl elemzse
+//   <id> pcm <frekvencia> <csatornk> <f32|s16> <bjtok> [kapcsolk]
+//                                                     a sort kvet <bjtok> bjtnyi tlapolt, little-endian minta elemzse
+//   <id> cancel <cl-id>                              egy vrakoz vagy fut krs megszaktsa
+//   <id> ping
+// A kapcsolk a parancssoriak (-dft, -w=, -f=, -profiles=, -mix=, -range=, ...); a -cache s a
+// -sidecar a kiszolgl indtsakor adhat meg. Egy kapcsolaton tbb krs is kldhet a vlaszok
+// megvrsa nlkl; a krsek prhuzamosan futnak, a vlaszok az elkszls sorrendjben, soronknt
+// egy JSON objektumknt rkeznek ("id", "status": ok / error / cancelled, eredmnynl "key",
+// "score", "reference", "histogram", "families", "cached", "ms").
+class AnalysisServer
+{
+public:
+	explicit AnalysisServer(const InitData& init);
+
+	AnalysisServer(const AnalysisServer&) = delete;
+	AnalysisServer& operator=(const AnalysisServer&) = delete;
+
+	// A socket ltrehozsa s a kapcsolatok fogadsa; csak hiba esetn tr vissza (1-gyel).
+	int Run();
+
+private:
+	struct Connection;
+
+	void Serve(std::shared_ptr<Connection> connection);
+	void Dispatch(const std::shared_ptr<Connection>& connection, const std::vector<std::string>& tokens, std::shared_ptr<std::vector<char>> payload);
+	std::string Execute(const std::string& id, const std::vector<std::string>& tokens, const std::vector<char>& payload, const std::atomic<bool>& cancel);
+	void Warm();
+	InitData ParseOptions(const std::vector<std::string>& options) const;
+
+	static std::vector<std::string> Tokenize(const std::string& line);
+	static std::string FormatStatus(const std::string& id, const std::string& status, const std::string& message = std::string());
+	static std::string FormatResult(const std::string& id, const FileResult& result, const bool cached, const double milliseconds);
+
+	InitData init;
+	std::shared_ptr<ThreadPool> pool;
+	std::unique_ptr<ResultCache> cache;
+};
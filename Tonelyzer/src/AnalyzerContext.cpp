@@ -0,0 +1,60 @@
+#include <stdexcept>
+
+#include "AnalyzerContext.h"
+#include "BatchAnalyzer.h"
+#include "PitchAnalyzer.h"
+#include "Reader.h"
+
+AnalyzerContext::AnalyzerContext(const InitData& settings)
+	: settings(settings)
+{
+	// A Transformer rvnytelen ablakmretnl a konzolra r s az alaprtkre vlt; a knyvtr inkbb jelez.
+	const unsigned windowSize = settings.FTWindowSize;
+	if (windowSize < 128 || windowSize > 32768 || (windowSize & (windowSize - 1)) != 0)
+		throw std::invalid_argument("Window size must be a power of two between 128 and 32768");
+
+	if (settings.FourierMode == FTmode::CQT && settings.BinsPerSemitone != 1 && settings.BinsPerSemitone != 3)
+		throw std::invalid_argument("CQT bins per semitone must be 1 or 3");
+
+	// Ugyangy a profilnevek: egyszer ellenrizve, hogy az elemzs mr ne rjon figyelmeztetst.
+	for (const ProfileSelection& profile : settings.Profiles)
+		if (!PitchAnalyzer::IsKnownProfile(profile.Name))
+			throw std::invalid_argument("Unknown key profile '" + profile.Name + "'");
+	this->settings.Profiles = PitchAnalyzer::ValidateProfiles(settings.Profiles);
+
+	pool = std::make_shared<ThreadPool>(settings.ThreadCount);
+}
+
+FileResult AnalyzerContext::Analyze(AudioSource& source, const ProgressCallback& progress, const std::atomic<bool>* cancel) const
+{
+	return BatchAnalyzer::Analyze(source, settings, pool, cancel, progress);
+}
+
+FileResult AnalyzerContext::Analyze(const float* interleaved, const size_t frames, const unsigned sampleRate, const unsigned channels,
+	const ProgressCallback& progress, const std::atomic<bool>* cancel) const
+{
+	BufferSource source(interleaved, frames, sampleRate, channels, settings.Input);
+	return Analyze(source, progress, cancel);
+}
+
+FileResult AnalyzerContext::Analyze(const int16_t* interleaved, const size_t frames, const unsigned sampleRate, const unsigned channels,
+	const ProgressCallback& progress, const std::atomic<bool>* cancel) const
+{
+	BufferSource source(interleaved, frames, sampleRate, channels, settings.Input);
+	return Analyze(source, progress, cancel);
+}
+
+FileResult AnalyzerContext::Analyze(const ReadCallback& read, const unsigned sampleRate, const unsigned channels,
+	const ProgressCallback& progress, const std::atomic<bool>* cancel) const
+{
+	CallbackSource source(read, sampleRate, channels, settings.Input);
+	return Analyze(source, progress, cancel);
+}
+
+FileResult AnalyzerContext::AnalyzeFile(const std::string& path, const ProgressCallback& progress, const std::atomic<bool>* cancel) const
+{
+	const std::unique_ptr<AudioSource> source = Reader::Open(path, settings.Input);
+	FileResult result = Analyze(*source, progress, cancel);
+	result.Path = path;
+	return result;
+}
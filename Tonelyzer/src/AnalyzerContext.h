@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "Structures.h"
+#include "ThreadPool.h"
+#include "Transformer.h"
+#include "BufferSource.h"
+#include "CallbackSource.h"
+
+// A begyazhat knyvtr (libtonelyzer) C++ fellete. Egy kontextus a belltsokat s a
+// szlkszletet fogja ssze; ltrehozs utn nem vltozik, gy tbb szlrl egyszerre is hvhat,
+// a hvsok a kzs szlkszleten osztoznak. Az FFT-tervek, ablaktblk s hangosztly-lekpezsek
+// a folyamatszint ::Get gyorsttrakban maradnak, gy az els hvs utn nem plnek jra.
+// Az elemzs nem r a konzolra: a haladsrl a megadott visszahvs rtest (ktegenknt, a hv
+// szln), a hibk kivtelknt jnnek (a megszakts AnalysisCancelled).
+// A kapcsolk kzl a parancssori mkdshez tartozk (Inputs, CachePath, SpectrumSidecar,
+// TrackSpan, ChromaPath, ServePath) itt nem szmtanak.
+class AnalyzerContext
+{
+public:
+	using ProgressCallback = Transformer::ProgressCallback;
+	using ReadCallback = CallbackSource::ReadCallback;
+
+	// rvnytelen ablakmret vagy ismeretlen profilnv esetn std::invalid_argument kivtelt dob.
+	explicit AnalyzerContext(const InitData& settings = InitData());
+
+	AnalyzerContext(const AnalyzerContext&) = delete;
+	AnalyzerContext& operator=(const AnalyzerContext&) = delete;
+
+	// tlapolt float (-1..1) vagy 16 bites egsz PCM jel elemzse
+	FileResult Analyze(const float* interleaved, const size_t frames, const unsigned sampleRate, const unsigned channels,
+		const ProgressCallback& progress = nullptr, const std::atomic<bool>* cancel = nullptr) const;
+	FileResult Analyze(const int16_t* interleaved, const size_t frames, const unsigned sampleRate, const unsigned channels,
+		const ProgressCallback& progress = nullptr, const std::atomic<bool>* cancel = nullptr) const;
+
+	// A visszahvs ltal, kimerlsig szolgltatott tlapolt float jel elemzse; a jel igny szerint,
+	// blokkonknt olvasdik (CallbackSource)
+	FileResult Analyze(const ReadCallback& read, const unsigned sampleRate, const unsigned channels,
+		const ProgressCallback& progress = nullptr, const std::atomic<bool>* cancel = nullptr) const;
+
+	// Hangfjl elemzse (a parancssori egyfjlos md megfelelje, kirs nlkl)
+	FileResult AnalyzeFile(const std::string& path, const ProgressCallback& progress = nullptr, const std::atomic<bool>* cancel = nullptr) const;
+
+	inline const InitData& GetSettings() const { return settings; }
+	inline unsigned GetThreadCount() const { return pool->GetThreadCount(); }
+
+private:
+	FileResult Analyze(AudioSource& source, const ProgressCallback& progress, const std::atomic<bool>* cancel) const;
+
+	InitData settings;
+	std::shared_ptr<ThreadPool> pool;
+};
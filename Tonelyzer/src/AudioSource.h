@@ -0,0 +1,80 @@
+#pragma once
+
+#include <limits>
+
+#include "Structures.h"
+
+// Mon mintkat folyamatosan szolgltat bemenet. A Transformer ezen keresztl, ablakonknt
+// olvassa a jelet, gy nem szksges a teljes fjlt a memriban tartani.
+// Idszakaszok (TimeRange) megadsakor a forrs csak ezeket dekdolja, egyms utn; a szakaszok
+// hatrn a Read 0-t ad vissza, s a NextSegment lp a kvetkezre.
+class AudioSource
+{
+public:
+	virtual ~AudioSource() = default;
+
+	// Legfeljebb count mon mintt r az output-ba; 0 az aktulis szakasz vgt jelzi.
+	virtual size_t Read(float* output, const size_t count) = 0;
+
+	// Az aktulis szakasz maradkt eldobja, s a kvetkezre lp; false, ha nincs tbb szakasz.
+	virtual bool NextSegment() = 0;
+
+	virtual unsigned GetSampleRate() const = 0;
+	virtual unsigned GetChannels() const = 0;
+
+	// A vrhat mon mintaszm az sszes szakaszra (a becslt futsid kijelzshez), 0 ha ismeretlen
+	virtual size_t GetLength() const = 0;
+
+	// Az aktulis szakasz kezdete a fjlban, msodpercben (az ablakok idblyegeihez)
+	virtual double GetSegmentStart() const = 0;
+
+	inline const std::string& GetFilename() const { return filename; }
+
+	// lsimt alulmintavtelezsnl a ritkts arnya (a GetSampleRate mr a ritktott frekvencia)
+	inline unsigned GetDecimationFactor() const { return decimationFactor; }
+
+protected:
+	// Kpkockkban megadott szakasz; Count == Unbounded esetn a fjl vgig tart.
+	struct Segment
+	{
+		size_t Start;
+		size_t Count;
+	};
+
+	static const size_t Unbounded = std::numeric_limits<size_t>::max();
+
+	// Az idszakaszok tvltsa kpkockkra a (ritkts eltti) mintavteli frekvencival.
+	// frames a fjl hossza kpkockban (0, ha ismeretlen). res lista esetn a teljes fjl egy szakasz.
+	static std::vector<Segment> GetSegments(const std::vector<TimeRange>& ranges, const unsigned sampleRate, const size_t frames)
+	{
+		std::vector<Segment> segments;
+		for (const TimeRange& range : ranges)
+		{
+			Segment segment;
+			segment.Start = static_cast<size_t>(std::llround(std::max(0.0, range.Start) * sampleRate));
+			segment.Count = range.Duration < 0.0 ? Unbounded : static_cast<size_t>(std::llround(range.Duration * sampleRate));
+			if (frames > 0)
+			{
+				segment.Start = std::min(segment.Start, frames);
+				segment.Count = std::min(segment.Count, frames - segment.Start);
+			}
+			segments.push_back(segment);
+		}
+
+		if (segments.empty())
+			segments.push_back({ 0, Unbounded });
+		return segments;
+	}
+
+	// A szakaszok egyttes hossza kpkockban (a becslshez); 0, ha a fjl hossza ismeretlen
+	static size_t GetSegmentsLength(const std::vector<Segment>& segments, const size_t frames)
+	{
+		size_t total = 0;
+		for (const Segment& segment : segments)
+			total += std::min(segment.Count, frames - std::min(segment.Start, frames));
+		return total;
+	}
+
+	std::string filename;
+	unsigned decimationFactor = 1;
+};
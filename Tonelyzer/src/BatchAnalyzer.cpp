@@ -0,0 +1,282 @@
+#include <fstream>
+
+#include "BatchAnalyzer.h"
+#include "Reader.h"
+#include "Transformer.h"
+#include "PitchAnalyzer.h"
+#include "SpectrumSidecar.h"
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+BatchAnalyzer::BatchAnalyzer(const InitData& init)
+	: init(init), pool(std::make_shared<ThreadPool>(init.ThreadCount))
+{
+	// A profilnevek ellenrzse egyszer, hogy ismeretlen nv esetn ne fjlonknt jjjn figyelmeztets.
+	this->init.Profiles = PitchAnalyzer::ValidateProfiles(init.Profiles);
+
+	if (init.TrackSpan > 0.0 || !init.ChromaPath.empty())
+		std::cerr << "Key tracking and chromagram export are only available for a single input file." << std::endl;
+
+	if (!init.CachePath.empty())
+	{
+		try
+		{
+			cache.reset(new ResultCache(init.CachePath));
+			parameterHash = ResultCache::GetParameterHash(init); // a megadott profillistval, mint egy fjlnl
+		}
+		catch (const std::exception& e)
+		{
+			std::cerr << e.what() << ", continuing without the cache." << std::endl;
+		}
+	}
+}
+
+bool BatchAnalyzer::IsDirectory(const std::string& path)
+{
+#if defined(_WIN32)
+	const DWORD attributes = GetFileAttributesA(path.c_str());
+	return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+#else
+	struct stat info;
+	return stat(path.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+#endif
+}
+
+// A libsndfile ltal olvashat, gyakori hangfjl-kiterjesztsek
+bool BatchAnalyzer::IsAudioFile(const std::string& path)
+{
+	static const char* const extensions[] = { "wav", "wave", "w64", "rf64", "flac", "ogg", "oga", "opus", "aif", "aiff", "aifc", "au", "snd", "caf", "mp3" };
+
+	const size_t dot = path.find_last_of('.');
+	if (dot == std::string::npos)
+		return false;
+
+	std::string extension = path.substr(dot + 1);
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+	return std::find(std::begin(extensions), std::end(extensions), extension) != std::end(extensions);
+}
+
+void BatchAnalyzer::ListDirectory(const std::string& directory, std::vector<std::string>& files)
+{
+	std::vector<std::string> entries;
+#if defined(_WIN32)
+	WIN32_FIND_DATAA data;
+	const HANDLE find = FindFirstFileA((directory + "\\*").c_str(), &data);
+	if (find == INVALID_HANDLE_VALUE)
+		return;
+	do
+	{
+		const std::string name = data.cFileName;
+		if (name != "." && name != "..")
+			entries.push_back(directory + "\\" + name);
+	} while (FindNextFileA(find, &data));
+	FindClose(find);
+#else
+	DIR* dir = opendir(directory.c_str());
+	if (!dir)
+		return;
+	while (const dirent* entry = readdir(dir))
+	{
+		const std::string name = entry->d_name;
+		if (name != "." && name != "..")
+			entries.push_back(directory + "/" + name);
+	}
+	closedir(dir);
+#endif
+
+	// Rendezett bejrs, hogy a feldolgozs sorrendje futsrl futsra azonos legyen.
+	std::sort(entries.begin(), entries.end());
+	for (const std::string& entry : entries)
+	{
+		if (IsDirectory(entry))
+			ListDirectory(entry, files);
+		else if (IsAudioFile(entry))
+			files.push_back(entry);
+	}
+}
+
+bool BatchAnalyzer::IsBatchInput(const std::string& input)
+{
+	return (!input.empty() && input[0] == '@') || IsDirectory(input);
+}
+
+std::vector<std::string> BatchAnalyzer::CollectInputs(const std::vector<std::string>& inputs)
+{
+	std::vector<std::string> files;
+	for (const std::string& input : inputs)
+	{
+		if (!input.empty() && input[0] == '@')
+		{
+			std::ifstream list(input.substr(1));
+			if (!list)
+			{
+				std::cerr << "Cannot open file list " << input.substr(1) << std::endl;
+				continue;
+			}
+
+			std::vector<std::string> listed;
+			std::string line;
+			while (std::getline(list, line))
+			{
+				if (!line.empty() && line.back() == '\r')
+					line.pop_back();
+				if (!line.empty())
+					listed.push_back(line);
+			}
+
+			const std::vector<std::string> expanded = CollectInputs(listed);
+			files.insert(files.end(), expanded.begin(), expanded.end());
+		}
+		else if (IsDirectory(input))
+			ListDirectory(input, files);
+		else
+			files.push_back(input);
+	}
+	return files;
+}
+
+FileResult BatchAnalyzer::Evaluate(const PitchAnalyzer& analyzer, const std::string& path, const InitData& init)
+{
+	FileResult result;
+	result.Path = path;
+	result.ReferencePitch = init.ReferencePitch;
+	if (init.EstimateTuning && analyzer.CanEstimateTuning())
+		result.ReferencePitch = init.ReferencePitch * std::pow(2.0f, analyzer.EstimateTuning(init.ReferencePitch) / 1200.0f);
+
+	result.Histogram = analyzer.CalculateHistogram(result.ReferencePitch);
+	result.Keys = analyzer.CalculateKeys(result.Histogram);
+	return result;
+}
+
+Spectrum BatchAnalyzer::Transform(AudioSource& source, const InitData& init, const std::shared_ptr<ThreadPool>& pool, const bool magnitudes, const std::atomic<bool>* cancel,
+	const Transformer::ProgressCallback& progress)
+{
+	// Alulmintavtelezsnl az ablakmret a ritkts arnyban cskken (lsd main).
+	unsigned windowSize = init.FTWindowSize;
+	if (source.GetDecimationFactor() > 1)
+		windowSize = std::max(128u, windowSize / source.GetDecimationFactor());
+
+	Transformer tr(source, windowSize);
+	tr.SetThreadPool(pool);
+	tr.SetWindowType(init.Window);
+	tr.SetReferencePitch(init.ReferencePitch);
+	tr.SetBinsPerSemitone(init.BinsPerSemitone);
+	tr.SetMagnitudeAverage(init.EstimateTuning || magnitudes);
+	tr.SetCancelFlag(cancel);
+	tr.SetProgressCallback(progress);
+	tr.SetVerbose(false);
+	return tr.AvgFourier(init.FourierMode);
+}
+
+FileResult BatchAnalyzer::Analyze(const std::string& path, const InitData& init, const std::shared_ptr<ThreadPool>& pool, const FileIdentity* identity, const std::atomic<bool>* cancel)
+{
+	// Meglv spektrumfjlnl a dekdols s a transzformci kimarad.
+	std::string sidecarPath;
+	const uint64_t transformHash = SpectrumSidecar::GetParameterHash(init);
+	if (identity && init.SpectrumSidecar)
+	{
+		sidecarPath = SpectrumSidecar::GetPath(path, init.SidecarDirectory, *identity, transformHash);
+		const std::unique_ptr<SpectrumSidecar> sidecar = SpectrumSidecar::Open(sidecarPath, *identity, transformHash);
+		if (sidecar)
+		{
+			PitchAnalyzer analyzer(*sidecar);
+			analyzer.SetProfiles(init.Profiles);
+			return Evaluate(analyzer, path, init);
+		}
+	}
+
+	// Szlkszlet-feladatban (ktegelt s kiszolgl md) a dekdols is a feladat szln fut: a
+	// prhuzamossgot a tbbi fjl adja, gy fjlonknt nem indul kln dekdol szl.
+	InputSettings input = init.Input;
+	input.BackgroundDecode = false;
+	std::unique_ptr<AudioSource> reader = Reader::Open(path, input);
+	const Spectrum spectrum = Transform(*reader, init, pool, !sidecarPath.empty(), cancel); // a spektrumfjl ksbbi -f=auto futshoz is elg legyen
+
+	if (!sidecarPath.empty() && !SpectrumSidecar::Write(sidecarPath, *identity, transformHash, spectrum))
+		std::cerr << "Cannot write the spectrum file " << sidecarPath << std::endl;
+
+	PitchAnalyzer analyzer(spectrum);
+	analyzer.SetProfiles(init.Profiles);
+	return Evaluate(analyzer, path, init);
+}
+
+FileResult BatchAnalyzer::Analyze(AudioSource& source, const InitData& init, const std::shared_ptr<ThreadPool>& pool, const std::atomic<bool>* cancel,
+	const Transformer::ProgressCallback& progress)
+{
+	const Spectrum spectrum = Transform(source, init, pool, false, cancel, progress);
+	PitchAnalyzer analyzer(spectrum);
+	analyzer.SetProfiles(init.Profiles);
+	return Evaluate(analyzer, source.GetFilename(), init);
+}
+
+void BatchAnalyzer::Process(const std::string& path)
+{
+	FileIdentity identity;
+	const bool identified = (cache || init.SpectrumSidecar) && ResultCache::GetFileIdentity(path, identity);
+
+	FileResult result;
+	result.Path = path;
+	if (identified && cache && cache->Find(identity, parameterHash, result))
+	{
+		cacheHits++;
+		Report(result, true);
+		return;
+	}
+
+	result = Analyze(path, init, pool, identified ? &identity : nullptr);
+	if (identified && cache)
+		cache->Store(identity, parameterHash, result);
+	Report(result, false);
+}
+
+void BatchAnalyzer::Report(const FileResult& result, const bool cached)
+{
+	std::lock_guard<std::mutex> lock(outputMutex);
+	std::cout << result.Path << ": " << PitchAnalyzer::GetKeyName(result.Keys.Ensemble.Key) << " (r = " << result.Keys.Ensemble.Score << ")";
+	if (init.EstimateTuning)
+		std::cout << ", A4 = " << result.ReferencePitch << " Hz";
+	if (cached)
+		std::cout << " [cached]";
+	std::cout << std::endl;
+}
+
+size_t BatchAnalyzer::Run(const std::vector<std::string>& paths)
+{
+	const auto before = std::chrono::high_resolution_clock::now();
+
+	for (const std::string& path : paths)
+	{
+		pool->Submit([this, path]()
+		{
+			try
+			{
+				Process(path);
+			}
+			catch (const std::exception& e)
+			{
+				failures++;
+				std::lock_guard<std::mutex> lock(outputMutex);
+				std::cerr << path << ": " << e.what() << std::endl;
+			}
+		});
+	}
+	pool->Wait();
+
+	const auto after = std::chrono::high_resolution_clock::now();
+	const float seconds = std::chrono::duration_cast<std::chrono::microseconds>(after - before).count() / 1000000.0f;
+	std::cout << "--------------------------------" << std::endl;
+	std::cout << "Tonelyzer: " << paths.size() << " files on " << pool->GetThreadCount() << " thread(s) in " << seconds << "s";
+	if (seconds > 0.0f)
+		std::cout << " (" << paths.size() / seconds << " files/s)";
+	if (cache)
+		std::cout << ", " << cacheHits << " from cache";
+	std::cout << ", " << failures << " failed" << std::endl;
+
+	return failures;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+#include "Structures.h"
+#include "ThreadPool.h"
+#include "ResultCache.h"
+#include "AudioSource.h"
+#include "Transformer.h"
+
+class PitchAnalyzer;
+
+// Tbb fjl elemzse egyetlen folyamatban, kzs munkalop szlkszleten. Minden fjl egy nll
+// feladat; a fjlon belli ablakcsomagokat (ParallelFor) a szabad szlak ellopjk, gy egy nagy
+// fjl sem hagy ttlenl szlakat, amg a kisebbek elkszlnek. Az eredmnyek az elkszls
+// sorrendjben, fjlonknt egy sorban rdnak ki. Megadott gyorsttr (-cache) esetn a vltozatlan
+// fjlok eredmnye dekdols nlkl, onnan kerl ki.
+class BatchAnalyzer
+{
+public:
+	explicit BatchAnalyzer(const InitData& init);
+
+	// Knyvtrak (rekurzvan, a tmogatott kiterjeszts fjlokra) s @listafjlok (soronknt egy
+	// tvonal) kibontsa; a tbbi bemenet vltozatlanul kerl a listba.
+	static std::vector<std::string> CollectInputs(const std::vector<std::string>& inputs);
+
+	// Igaz, ha a bemenet knyvtr vagy listafjl, vagyis ktegelt mdot jelent.
+	static bool IsBatchInput(const std::string& input);
+
+	// Egy fjl teljes elemzse kirs nlkl; sikertelen megnyitsnl kivtelt dob. Ismert azonost s
+	// -sidecar esetn a spektrumfjlt hasznlja, ill. hozza ltre. A cancel jelzvel az elemzs
+	// megszakthat (AnalysisCancelled).
+	static FileResult Analyze(const std::string& path, const InitData& init, const std::shared_ptr<ThreadPool>& pool,
+		const FileIdentity* identity = nullptr, const std::atomic<bool>* cancel = nullptr);
+
+	// Egy mr megnyitott (pl. memriabeli) forrs elemzse kirs nlkl, igny szerint haladsjelzssel
+	static FileResult Analyze(AudioSource& source, const InitData& init, const std::shared_ptr<ThreadPool>& pool, const std::atomic<bool>* cancel = nullptr,
+		const Transformer::ProgressCallback& progress = nullptr);
+
+	// Az sszes fjl elemzse; a sikertelen fjlok szmt adja vissza.
+	size_t Run(const std::vector<std::string>& paths);
+
+private:
+	static bool IsDirectory(const std::string& path);
+	static bool IsAudioFile(const std::string& path);
+	static void ListDirectory(const std::string& directory, std::vector<std::string>& files);
+
+	static Spectrum Transform(AudioSource& source, const InitData& init, const std::shared_ptr<ThreadPool>& pool, const bool magnitudes, const std::atomic<bool>* cancel,
+		const Transformer::ProgressCallback& progress = nullptr);
+	static FileResult Evaluate(const PitchAnalyzer& analyzer, const std::string& path, const InitData& init);
+
+	void Process(const std::string& path);
+	void Report(const FileResult& result, const bool cached);
+
+	InitData init;
+	std::shared_ptr<ThreadPool> pool;
+	std::unique_ptr<ResultCache> cache;
+	uint64_t parameterHash = 0;
+	std::mutex outputMutex;
+	std::atomic<size_t> failures{ 0 };
+	std::atomic<size_t> cacheHits{ 0 };
+};
@@ -0,0 +1,96 @@
+#include <cstring>
+#include <stdexcept>
+
+#include "BufferSource.h"
+#include "Decimator.h"
+#include "Downmixer.h"
+
+const size_t BufferSource::ConvertFrames;
+
+template <typename Converter>
+void BufferSource::Prepare(const size_t frames, const InputSettings& settings, Converter convert)
+{
+	if (sampleRate == 0 || channels == 0 || frames == 0)
+		throw std::runtime_error("Invalid sample rate, channel count or empty buffer");
+
+	const Downmixer downmixer(channels, settings.Downmix);
+	std::unique_ptr<Decimator> decimator;
+	if (settings.Decimate)
+	{
+		decimator.reset(new Decimator(sampleRate));
+		decimationFactor = decimator->GetFactor();
+	}
+
+	// talakts s lekevers kis blokkonknt, hogy az tlapolt float jel ne kerljn egszben a memriba.
+	std::vector<float> block(ConvertFrames * channels);
+	std::vector<float> mono(ConvertFrames);
+	for (const Segment& segment : GetSegments(settings.Ranges, sampleRate, frames))
+	{
+		std::vector<float> data;
+		if (decimator)
+			decimator->Reset();
+
+		// Tartomny nlkl a szakasz hossza Unbounded, ezrt a puffer vgre vgjuk.
+		const size_t end = segment.Start + std::min(segment.Count, frames - segment.Start);
+		for (size_t first = segment.Start; first < end; first += ConvertFrames)
+		{
+			const size_t count = std::min(ConvertFrames, end - first);
+			convert(first, count, block.data());
+			downmixer.Process(block.data(), count, mono.data());
+			if (decimator)
+				decimator->Process(mono.data(), count, data);
+			else
+				data.insert(data.end(), mono.begin(), mono.begin() + count);
+		}
+
+		length += data.size();
+		segmentData.push_back(std::move(data));
+		segmentStarts.push_back(segment.Start / static_cast<double>(sampleRate));
+	}
+
+	if (decimator)
+		sampleRate = decimator->GetOutputSampleRate();
+}
+
+BufferSource::BufferSource(const float* interleaved, const size_t frames, const unsigned sampleRate, const unsigned channels,
+	const InputSettings& settings, const std::string& name)
+	: sampleRate(sampleRate), channels(channels)
+{
+	filename = name;
+	Prepare(frames, settings, [&](const size_t first, const size_t count, float* output)
+	{
+		std::memcpy(output, interleaved + first * channels, count * channels * sizeof(float));
+	});
+}
+
+BufferSource::BufferSource(const int16_t* interleaved, const size_t frames, const unsigned sampleRate, const unsigned channels,
+	const InputSettings& settings, const std::string& name)
+	: sampleRate(sampleRate), channels(channels)
+{
+	filename = name;
+	Prepare(frames, settings, [&](const size_t first, const size_t count, float* output)
+	{
+		const int16_t* input = interleaved + first * channels;
+		for (size_t i = 0; i < count * channels; i++)
+			output[i] = input[i] * (1.0f / 32768.0f);
+	});
+}
+
+size_t BufferSource::Read(float* output, const size_t count)
+{
+	const std::vector<float>& data = segmentData[segmentIndex];
+	const size_t n = std::min(count, data.size() - position);
+	std::copy(data.begin() + position, data.begin() + position + n, output);
+	position += n;
+	return n;
+}
+
+bool BufferSource::NextSegment()
+{
+	if (segmentIndex + 1 >= segmentData.size())
+		return false;
+
+	segmentIndex++;
+	position = 0;
+	return true;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+
+#include "AudioSource.h"
+
+// Memriban lv, tlapolt PCM jel (float vagy 16 bites egsz) mint bemenet, pl. a kiszolgl
+// mdban socketen rkez vagy a begyaz programtl kapott mintkhoz. A megadott idszakaszok
+// mon jele (igny szerint ritktva) a konstruktorban, egyszer kszl el; a Read ebbl msol.
+class BufferSource : public AudioSource
+{
+public:
+	BufferSource(const float* interleaved, const size_t frames, const unsigned sampleRate, const unsigned channels,
+		const InputSettings& settings = InputSettings(), const std::string& name = "<buffer>");
+	BufferSource(const int16_t* interleaved, const size_t frames, const unsigned sampleRate, const unsigned channels,
+		const InputSettings& settings = InputSettings(), const std::string& name = "<buffer>");
+
+	size_t Read(float* output, const size_t count) override;
+	bool NextSegment() override;
+
+	inline unsigned GetSampleRate() const override { return sampleRate; }
+	inline unsigned GetChannels() const override { return channels; }
+	inline size_t GetLength() const override { return length; }
+	inline double GetSegmentStart() const override { return segmentStarts[segmentIndex]; }
+
+private:
+	static const size_t ConvertFrames = 2048;
+
+	// convert: a kpkockk [first, first + count) tartomnyt float tlapolt mintkk alaktja
+	template <typename Converter>
+	void Prepare(const size_t frames, const InputSettings& settings, Converter convert);
+
+	unsigned sampleRate;
+	unsigned channels;
+	size_t length = 0;
+
+	std::vector<std::vector<float>> segmentData; // szakaszonknt a (ritktott) mon jel
+	std::vector<double> segmentStarts;
+	size_t segmentIndex = 0;
+	size_t position = 0;
+};
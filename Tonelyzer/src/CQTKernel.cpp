@@ -0,0 +1,139 @@
+#include <algorithm>
+
+#include "CQTKernel.h"
+#include "LruCache.h"
+#include "FFTPlan.h"
+
+const uint32_t CQTKernel::Revision;
+
+// A spektrlis kernel egytthati kzl a bin legnagyobb egytthatjhoz kpest ennl kisebbeket elhagyjuk.
+static const float SparsityThreshold = 0.01f;
+
+CQTKernel::CQTKernel(const unsigned sampleRate, const unsigned windowSize, const float referencePitch, const unsigned binsPerSemitone, const WindowType windowType)
+	: binsPerSemitone(binsPerSemitone)
+{
+	const std::pair<int, int> range = GetAnalysisNoteRange(referencePitch, sampleRate);
+	firstMidi = range.first;
+	const int noteCount = std::max(range.second - range.first + 1, 0);
+	const size_t binCount = static_cast<size_t>(noteCount) * binsPerSemitone;
+
+	// Q = 1 / (2^(1 / bins per octave) - 1)
+	const double Q = 1.0 / (std::pow(2.0, 1.0 / (12.0 * binsPerSemitone)) - 1.0);
+
+	// Bin-enknt a kzpfrekvencia, a piramisszint (a legmlyebb, ahol a frekvencia mg legfeljebb a
+	// szint mintavteli frekvencijnak negyede) s a szinten Q peridusnyi idbeli kernel hossza
+	std::vector<double> frequencies(binCount);
+	std::vector<size_t> levels(binCount);
+	std::vector<size_t> lengths(binCount);
+	for (size_t k = 0; k < binCount; k++)
+	{
+		// A hang krli bin-ek egyenletesen, a hangkzpponthoz kpest szimmetrikusan helyezkednek el.
+		const double offset = (static_cast<double>(k % binsPerSemitone) - (binsPerSemitone - 1) / 2.0) / binsPerSemitone;
+		const double midi = firstMidi + static_cast<double>(k / binsPerSemitone) + offset;
+		frequencies[k] = referencePitch * std::pow(2.0, (midi - 69.0) / 12.0);
+		levels[k] = static_cast<size_t>(std::max(0.0, std::floor(std::log2(sampleRate / (4.0 * frequencies[k])))));
+		lengths[k] = static_cast<size_t>(std::ceil(Q * sampleRate / std::pow(2.0, static_cast<double>(levels[k])) / frequencies[k]));
+	}
+
+	// A frekvencival a szint nem n, gy az azonos szint bin-ek egyms utn kvetkeznek.
+	for (size_t k = 0; k < binCount; k++)
+	{
+		if (bands.empty() || bands.back().Level != levels[k])
+			bands.push_back(Band{ k, 0, levels[k], 1, 1, nullptr });
+		Band& band = bands.back();
+		band.BinCount++;
+		while (band.FrameSize < lengths[k])
+			band.FrameSize *= 2;
+	}
+
+	// A keretek kzppontja az ablakokval egyezik. Egy sv kerete a ritkt szrkkel egytt az eredeti
+	// jelben 2^Level * (FrameSize / 2 + FilterReach) mintra nylik a kzpponttl; frameSize ezt fogja t
+	// (windowSize egsz szm tbbszrseknt, hogy a lpsek szma is egsz legyen).
+	const unsigned baseSize = std::max(windowSize, 1u);
+	frameSize = baseSize;
+	for (Band& band : bands)
+	{
+		const size_t reach = (static_cast<size_t>(band.FrameSize) / 2 + OctavePyramid::FilterReach + 1) << band.Level;
+		frameSize = std::max(frameSize, static_cast<unsigned>((2 * reach + baseSize - 1) / baseSize * baseSize));
+		// Lpskz: windowSize / 2; a sv keretnek felnl srbben nem kell futnia.
+		band.Stride = static_cast<unsigned>(std::max<size_t>(1, (static_cast<size_t>(band.FrameSize) << band.Level) / baseSize));
+		band.Plan = RealFFTPlan::Get(band.FrameSize);
+	}
+
+	binStarts.push_back(0);
+	FTdata temporal;
+	for (const Band& band : bands)
+	{
+		const size_t fftSize = band.FrameSize;
+		const size_t half = fftSize / 2;
+		const double levelRate = sampleRate / std::pow(2.0, static_cast<double>(band.Level));
+		const std::shared_ptr<const FFTPlan> plan = FFTPlan::Get(fftSize);
+		temporal.resize(fftSize);
+
+		for (size_t k = band.FirstBin; k < band.FirstBin + band.BinCount; k++)
+		{
+			// A keret kzepre igaztott kernel
+			const double f = frequencies[k];
+			const size_t length = lengths[k];
+			const size_t start = (fftSize - length) / 2;
+			const std::vector<float> window = WindowFunction::Build(windowType, length);
+
+			std::fill(temporal.begin(), temporal.end(), std::complex<float>(0.0f, 0.0f));
+			for (size_t n = 0; n < length; n++)
+			{
+				const double phase = 2.0 * 3.14159265358979323846 * f * n / levelRate;
+				const double w = window[n] / static_cast<double>(length);
+				temporal[start + n] = std::complex<float>(static_cast<float>(w * std::cos(phase)), static_cast<float>(w * std::sin(phase)));
+			}
+
+			plan->Forward(temporal);
+
+			// Csak a pozitv frekvencik szmtanak (a vals bemenet fl-spektrumval szorzunk).
+			float peak = 0.0f;
+			for (size_t j = 0; j <= half; j++)
+				peak = std::max(peak, std::abs(temporal[j]));
+
+			for (size_t j = 0; j <= half; j++)
+			{
+				if (std::abs(temporal[j]) < SparsityThreshold * peak)
+					continue;
+
+				// A konjuglt kernelt troljuk, az 1/N normlssal egytt.
+				const std::complex<float> value = std::conj(temporal[j]) / static_cast<float>(fftSize);
+				indices.push_back(static_cast<unsigned>(j));
+				kernelRe.push_back(value.real());
+				kernelIm.push_back(value.imag());
+			}
+
+			binStarts.push_back(indices.size());
+		}
+	}
+}
+
+// CQ[k] = sum_j X[j] * conj(K_k[j]) / N
+void CQTKernel::Apply(const size_t band, const FTdata& spectrum, FTdata& result) const
+{
+	result.resize(GetBinCount());
+
+	const Band& current = bands[band];
+	for (size_t k = current.FirstBin; k < current.FirstBin + current.BinCount; k++)
+	{
+		float re = 0.0f, im = 0.0f;
+		for (size_t e = binStarts[k]; e < binStarts[k + 1]; e++)
+		{
+			const std::complex<float> x = spectrum[indices[e]];
+			re += x.real() * kernelRe[e] - x.imag() * kernelIm[e];
+			im += x.real() * kernelIm[e] + x.imag() * kernelRe[e];
+		}
+		result[k] = std::sqrt(re * re + im * im);
+	}
+}
+
+std::shared_ptr<const CQTKernel> CQTKernel::Get(const unsigned sampleRate, const unsigned windowSize, const float referencePitch, const unsigned binsPerSemitone, const WindowType windowType)
+{
+	static LruCache<std::tuple<unsigned, unsigned, float, unsigned, WindowType>, CQTKernel> cache(CacheCapacity);
+	return cache.Get(std::make_tuple(sampleRate, windowSize, referencePitch, binsPerSemitone, windowType), [&]()
+	{
+		return std::make_shared<const CQTKernel>(sampleRate, windowSize, referencePitch, binsPerSemitone, windowType);
+	});
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <tuple>
+
+#include "FFTPlan.h"
+#include "OctavePyramid.h"
+#include "Structures.h"
+#include "WindowFunction.h"
+
+// Konstans Q-j transzformci Brown-Puckette fle ritka spektrlis kernellel, oktvonknt ritktott
+// jelen (Schrkhuber-Klapuri). A bin-ek flhangonknt BinsPerSemitone srsggel, mrtani sorban
+// kvetik egymst (a MinAnalysisFrequency - MaxAnalysisFrequency tartomnyban). Minden bin a jelpiramis
+// (OctavePyramid) azon szintjn fut, ahol a frekvencija mg a szint mintavteli frekvencijnak
+// negyede alatt van; egy szint bin-jei egy svot alkotnak, rvid, kzs FFT-kerettel. A kernelek gy
+// mindentt csak nhny szz mintsak, a mly hangok mgis a teljes Q felbontst kapjk.
+// A lpskz windowSize / 2, a keretek kzppontja az ablakokval egyezik; a mly svok, amelyek
+// kerete tbb lpst is tfog, csak minden Stride. lpsben futnak.
+class CQTKernel
+{
+public:
+	// A kernelpts vltozata: a tarts gyorsttrak paramterkulcsba kerl (CQT mdban).
+	static const uint32_t Revision = 3;
+
+	CQTKernel(const unsigned sampleRate, const unsigned windowSize, const float referencePitch, const unsigned binsPerSemitone, const WindowType windowType);
+
+	// A piramis egy szintjn fut, egymst kvet bin-ek
+	struct Band
+	{
+		size_t FirstBin;
+		size_t BinCount;
+		size_t Level;       // a jelpiramis szintje (a mintavteli frekvencia 2^Level-ed rsze)
+		unsigned FrameSize; // a sv FFT-jnek mrete, a szint mintiban
+		unsigned Stride;    // a sv minden Stride. lpsben szmoland
+		std::shared_ptr<const RealFFTPlan> Plan;
+	};
+
+	// spectrum: a sv szintjnek (center >> Level) - FrameSize / 2 indextl kezdd FrameSize minta
+	// ablakozatlan fl-spektruma, ahol center a keret kzepe az eredeti jelben. A result (GetBinCount()
+	// elem) a sv bin-jeinek helyn kap egy-egy amplitdt, a tbbi elem nem vltozik.
+	void Apply(const size_t band, const FTdata& spectrum, FTdata& result) const;
+
+	inline int GetFirstMidi() const { return firstMidi; }
+	inline unsigned GetBinsPerSemitone() const { return binsPerSemitone; }
+	inline size_t GetBinCount() const { return binStarts.size() - 1; }
+	// Az eredeti jel ennyi mintja kell egy kerethez: a kzppontja krl ennyin bell van minden
+	// sv kerete a ritkt szrkkel egytt (windowSize tbbszrse).
+	inline unsigned GetFrameSize() const { return frameSize; }
+	// A jelpiramis szksges szintjeinek szma
+	inline size_t GetLevelCount() const { return bands.empty() ? 1 : bands.front().Level + 1; }
+	inline size_t GetBandCount() const { return bands.size(); }
+	inline const Band& GetBand(const size_t band) const { return bands[band]; }
+
+	// Konfigurcinknt megosztott pldny; a legutbb hasznlt CacheCapacity konfigurci marad meg
+	// (a kernelek a referencia-hangmagassgtl fggnek).
+	static std::shared_ptr<const CQTKernel> Get(const unsigned sampleRate, const unsigned windowSize, const float referencePitch, const unsigned binsPerSemitone, const WindowType windowType);
+
+private:
+	static const size_t CacheCapacity = 4;
+
+	int firstMidi;
+	unsigned binsPerSemitone;
+	unsigned frameSize;
+	std::vector<Band> bands; // a mlytl a magas fel
+
+	// Tmrtett sorfolytonos (CSR) trols: a k. bin egytthati [binStarts[k], binStarts[k+1]) kztt,
+	// az indexek a bin svjnak fl-spektrumra vonatkoznak.
+	std::vector<size_t> binStarts;
+	std::vector<unsigned> indices;
+	std::vector<float> kernelRe;
+	std::vector<float> kernelIm;
+};
@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "CallbackSource.h"
+
+const size_t CallbackSource::BlockFrames;
+
+CallbackSource::CallbackSource(const ReadCallback& read, const unsigned sampleRate, const unsigned channels,
+	const InputSettings& settings, const std::string& name)
+	: read(read), sampleRate(sampleRate), channels(channels), downmixer(channels == 0 ? 1 : channels, settings.Downmix)
+{
+	filename = name;
+	if (sampleRate == 0 || channels == 0)
+		throw std::runtime_error("Invalid sample rate or channel count");
+
+	segments = GetSegments(settings.Ranges, sampleRate, 0);
+	for (size_t s = 1; s < segments.size(); s++)
+	{
+		const Segment& previous = segments[s - 1];
+		if (previous.Count == Unbounded || segments[s].Start < previous.Start + previous.Count)
+			throw std::runtime_error("Ranges of a callback input must be increasing and must not overlap");
+	}
+
+	if (settings.Decimate)
+	{
+		decimator.reset(new Decimator(sampleRate));
+		decimationFactor = decimator->GetFactor();
+	}
+
+	interleaved.resize(BlockFrames * channels);
+	mono.resize(BlockFrames);
+	pending.reserve(BlockFrames);
+}
+
+size_t CallbackSource::Pull(const size_t frames)
+{
+	if (exhausted)
+		return 0;
+
+	const size_t received = std::min(frames, read(interleaved.data(), frames));
+	if (received == 0)
+		exhausted = true;
+	streamPosition += received;
+	return received;
+}
+
+bool CallbackSource::Fill()
+{
+	pending.clear();
+	pendingPosition = 0;
+
+	// A szakasz eltti rsz olvassa s eldobsa
+	const Segment& segment = segments[segmentIndex];
+	while (streamPosition < segment.Start)
+		if (Pull(std::min(BlockFrames, segment.Start - streamPosition)) == 0)
+			return false;
+
+	const size_t end = segment.Count == Unbounded ? Unbounded : segment.Start + segment.Count;
+	if (streamPosition >= end)
+		return false;
+
+	const size_t count = Pull(std::min(BlockFrames, end - streamPosition));
+	if (count == 0)
+		return false;
+
+	downmixer.Process(interleaved.data(), count, mono.data());
+	if (decimator)
+		decimator->Process(mono.data(), count, pending);
+	else
+		pending.assign(mono.begin(), mono.begin() + count);
+	return true;
+}
+
+size_t CallbackSource::Read(float* output, const size_t count)
+{
+	size_t written = 0;
+	while (written < count)
+	{
+		// A ritkt egy blokkbl akr 0 mintt is adhat, ezrt a kvetkez blokkal folytatjuk.
+		if (pendingPosition == pending.size())
+		{
+			if (!Fill())
+				break;
+			continue;
+		}
+
+		const size_t n = std::min(count - written, pending.size() - pendingPosition);
+		std::copy(pending.begin() + pendingPosition, pending.begin() + pendingPosition + n, output + written);
+		pendingPosition += n;
+		written += n;
+	}
+	return written;
+}
+
+bool CallbackSource::NextSegment()
+{
+	if (segmentIndex + 1 >= segments.size())
+		return false;
+
+	segmentIndex++;
+	pending.clear();
+	pendingPosition = 0;
+	if (decimator)
+		decimator->Reset();
+	return true;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+
+#include "AudioSource.h"
+#include "Decimator.h"
+#include "Downmixer.h"
+
+// Visszahvsbl, igny szerint olvasott tlapolt float jel (a libtonelyzer tlz_analyze_callback
+// bemenete). A Read csak annyit kr a visszahvstl, amennyi a kvetkez blokkhoz kell, s azt
+// rgtn monv keveri (igny szerint ritktja), gy a memriaigny a jel hossztl fggetlen.
+// A jel csak elrefel olvashat: az idszakaszoknak nvekv sorrendben, tfeds nlkl kell
+// kvetkeznik, a kzttk lv rszt a forrs olvassa s eldobja. A hossz elre nem ismert
+// (GetLength() == 0).
+class CallbackSource : public AudioSource
+{
+public:
+	// Legfeljebb frames kpkockt r az tlapolt pufferbe, s a bertak szmt adja vissza; 0: a jel vge.
+	using ReadCallback = std::function<size_t(float* interleaved, const size_t frames)>;
+
+	// rvnytelen mintavteli frekvencia, csatornaszm vagy nem nvekv idszakaszok esetn
+	// std::runtime_error kivtelt dob.
+	CallbackSource(const ReadCallback& read, const unsigned sampleRate, const unsigned channels,
+		const InputSettings& settings = InputSettings(), const std::string& name = "<callback>");
+
+	size_t Read(float* output, const size_t count) override;
+	bool NextSegment() override;
+
+	inline unsigned GetSampleRate() const override { return decimator ? decimator->GetOutputSampleRate() : sampleRate; }
+	inline unsigned GetChannels() const override { return channels; }
+	inline size_t GetLength() const override { return 0; }
+	inline double GetSegmentStart() const override { return segments[segmentIndex].Start / static_cast<double>(sampleRate); }
+
+private:
+	static const size_t BlockFrames = 2048;
+
+	// Legfeljebb frames kpkocka a visszahvsbl az interleaved pufferbe
+	size_t Pull(const size_t frames);
+	// Az aktulis szakasz kvetkez blokkja a pending pufferbe; false a szakasz (vagy a jel) vgn.
+	bool Fill();
+
+	ReadCallback read;
+	unsigned sampleRate; // a ritkts eltti frekvencia
+	unsigned channels;
+	Downmixer downmixer;
+	std::unique_ptr<Decimator> decimator;
+
+	std::vector<Segment> segments;
+	size_t segmentIndex = 0;
+	size_t streamPosition = 0; // a visszahvsbl eddig kapott kpkockk
+	bool exhausted = false;
+
+	std::vector<float> interleaved;
+	std::vector<float> mono;
+	std::vector<float> pending; // az aktulis blokk mon (ritktott) minti
+	size_t pendingPosition = 0;
+};
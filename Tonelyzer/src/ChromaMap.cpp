@@ -0,0 +1,100 @@
+#include "ChromaMap.h"
+#include "LruCache.h"
+
+ChromaMap::ChromaMap(const unsigned sampleRate, const unsigned fftSize, const float referencePitch)
+{
+	const size_t halfSize = fftSize / 2;
+	bool first = true;
+
+	for (size_t k = 1; k < halfSize; k++)
+	{
+		const float f = k * sampleRate / (float) fftSize;
+		if (f < MinAnalysisFrequency || f > MaxAnalysisFrequency)
+		{
+			// A frekvencia monoton n, a hasznlhat bin-ek egy sszefgg tartomnyt alkotnak.
+			if (!first)
+				break;
+			continue;
+		}
+
+		if (first)
+		{
+			firstBin = k;
+			first = false;
+		}
+
+		// Az als hang az egsz rszhez, a fels a kerektett MIDI hanghoz kapja a trtrsz arny slyt.
+		const float midi = FrequencyToMidi(f, referencePitch);
+		const float frac = std::fmod(midi, 1.0f);
+		loPitch.push_back(static_cast<uint8_t>(static_cast<unsigned>(std::floor(midi)) % 12));
+		hiPitch.push_back(static_cast<uint8_t>(static_cast<unsigned>(std::round(midi)) % 12));
+		loWeight.push_back(1.0f - frac);
+		hiWeight.push_back(frac);
+		finePitch.push_back(static_cast<uint8_t>(static_cast<unsigned>(std::round(midi * FineChromaResolution)) % (12 * FineChromaResolution)));
+	}
+}
+
+void ChromaMap::Fold(const std::complex<float>* spectrum, PitchHistogram& histogram) const
+{
+	const size_t count = GetBinCount();
+	const std::complex<float>* bins = spectrum + firstBin;
+
+	// Amplitd s slyozs egy vektorizlhat ciklusban, blokkonknt a verem-pufferekbe
+	const size_t blockSize = 256;
+	float lo[blockSize], hi[blockSize];
+	for (size_t start = 0; start < count; start += blockSize)
+	{
+		const size_t n = std::min(blockSize, count - start);
+		for (size_t i = 0; i < n; i++)
+		{
+			const float re = bins[start + i].real(), im = bins[start + i].imag();
+			const float ampl = std::sqrt(re * re + im * im);
+			lo[i] = ampl * loWeight[start + i];
+			hi[i] = ampl * hiWeight[start + i];
+		}
+
+		// Sztszrs a 12 hangosztlyba
+		for (size_t i = 0; i < n; i++)
+		{
+			histogram[loPitch[start + i]] += lo[i];
+			histogram[hiPitch[start + i]] += hi[i];
+		}
+	}
+}
+
+void ChromaMap::FoldFine(const std::complex<float>* spectrum, FineChroma& chroma) const
+{
+	const std::complex<float>* bins = spectrum + firstBin;
+	for (size_t i = 0; i < finePitch.size(); i++)
+		chroma[finePitch[i]] += std::abs(bins[i]);
+}
+
+void ChromaMap::Rotate(const FineChroma& chroma, const float cents, PitchHistogram& histogram)
+{
+	for (size_t i = 0; i < chroma.size(); i++)
+	{
+		// Az osztly kzepe a becslt hangolshoz mrve; +12, hogy a negatv eltols se menjen 0 al.
+		const float midi = static_cast<float>(i) / FineChromaResolution - cents / 100.0f + 12.0f;
+		const float frac = std::fmod(midi, 1.0f);
+		histogram[static_cast<unsigned>(std::floor(midi)) % 12] += chroma[i] * (1.0f - frac);
+		histogram[static_cast<unsigned>(std::round(midi)) % 12] += chroma[i] * frac;
+	}
+}
+
+void ChromaMap::FoldNotes(const std::complex<float>* bins, const size_t count, const int firstMidi, const unsigned binsPerSemitone, PitchHistogram& histogram)
+{
+	for (size_t k = 0; k < count; k++)
+	{
+		const int midi = firstMidi + static_cast<int>(k / binsPerSemitone);
+		histogram[static_cast<unsigned>(midi) % 12] += std::abs(bins[k]);
+	}
+}
+
+std::shared_ptr<const ChromaMap> ChromaMap::Get(const unsigned sampleRate, const unsigned fftSize, const float referencePitch)
+{
+	static LruCache<std::tuple<unsigned, unsigned, float>, ChromaMap> cache(CacheCapacity);
+	return cache.Get(std::make_tuple(sampleRate, fftSize, referencePitch), [&]()
+	{
+		return std::make_shared<const ChromaMap>(sampleRate, fftSize, referencePitch);
+	});
+}
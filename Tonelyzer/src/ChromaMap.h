@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <tuple>
+
+#include "Structures.h"
+
+// Elre kiszmolt, ritka bin -> hangosztly lekpezs a fl-spektrumhoz.
+// Minden, a MinAnalysisFrequency - MaxAnalysisFrequency tartomnyba es binhez kt hangosztly-index
+// s kt interpolcis sly tartozik (SoA trols). Az rtkek csak a (mintavteli frekvencia,
+// FFT mret, referencia-hangmagassg) hrmastl fggenek, gy konfigurcinknt egyszer plnek fel,
+// s a hisztogram kpzse mr csak amplitd * sly szorzsokbl s sszeadsokbl ll.
+class ChromaMap
+{
+public:
+	ChromaMap(const unsigned sampleRate, const unsigned fftSize, const float referencePitch);
+
+	// A spektrum (legalbb fftSize/2 bin) amplitdinak hozzadsa a hisztogramhoz
+	void Fold(const std::complex<float>* spectrum, PitchHistogram& histogram) const;
+	inline void Fold(const FTdata& spectrum, PitchHistogram& histogram) const { Fold(spectrum.data(), histogram); }
+
+	// A spektrum amplitdinak hozzadsa a finom hangosztly-vektorhoz (minden bin a legkzelebbi osztlyba)
+	void FoldFine(const std::complex<float>* spectrum, FineChroma& chroma) const;
+	inline void FoldFine(const FTdata& spectrum, FineChroma& chroma) const { FoldFine(spectrum.data(), chroma); }
+
+	// Finom hangosztly-vektor 12 osztlyra kpzse a referencitl cents centtel eltr hangolsra,
+	// a Fold() als/fels hangra oszt szablyval; a hiba legfeljebb fl finom osztly.
+	static void Rotate(const FineChroma& chroma, const float cents, PitchHistogram& histogram);
+
+	// Hangkzpont (GOERTZEL, CQT) spektrum sszegzse: a k. bin a firstMidi + k / binsPerSemitone hanghoz tartozik.
+	static void FoldNotes(const std::complex<float>* bins, const size_t count, const int firstMidi, const unsigned binsPerSemitone, PitchHistogram& histogram);
+	static inline void FoldNotes(const FTdata& bins, const int firstMidi, const unsigned binsPerSemitone, PitchHistogram& histogram)
+	{
+		FoldNotes(bins.data(), bins.size(), firstMidi, binsPerSemitone, histogram);
+	}
+
+	inline size_t GetFirstBin() const { return firstBin; }
+	inline size_t GetBinCount() const { return loWeight.size(); }
+
+	// Konfigurcinknt megosztott pldny; a legutbb hasznlt CacheCapacity konfigurci marad meg.
+	static std::shared_ptr<const ChromaMap> Get(const unsigned sampleRate, const unsigned fftSize, const float referencePitch);
+
+private:
+	static const size_t CacheCapacity = 8;
+
+	size_t firstBin = 0;
+	std::vector<uint8_t> loPitch;
+	std::vector<uint8_t> hiPitch;
+	std::vector<float> loWeight;
+	std::vector<float> hiWeight;
+	std::vector<uint8_t> finePitch;
+};
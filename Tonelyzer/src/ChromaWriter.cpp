@@ -0,0 +1,185 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#include "ChromaWriter.h"
+
+// IEEE 754 flpontos szm a legkzelebbi (dntetlennl pros) rtkre kerektve
+static uint16_t ToHalf(const float value)
+{
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	const uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000u);
+	const uint32_t magnitude = bits & 0x7FFFFFFFu;
+
+	if (magnitude >= 0x7F800000u) // vgtelen vagy NaN
+		return sign | (magnitude > 0x7F800000u ? 0x7E00u : 0x7C00u);
+	if (magnitude >= 0x477FF000u) // a legnagyobb flpontos szm (65504) fl kerekedne
+		return sign | 0x7C00u;
+	if (magnitude < 0x33000001u) // a legkisebb szubnormlis szm fele alatt
+		return sign;
+
+	const int exponent = static_cast<int>(magnitude >> 23) - 127;
+	uint32_t mantissa = (magnitude & 0x007FFFFFu) | 0x00800000u;
+	if (exponent < -14)
+	{
+		// Szubnormlis eredmny: a rejtett bittel egytt jobbra toljuk.
+		const unsigned shift = static_cast<unsigned>(-exponent - 14) + 13;
+		const uint32_t rest = mantissa & ((1u << shift) - 1);
+		const uint32_t halfway = 1u << (shift - 1);
+		mantissa >>= shift;
+		if (rest > halfway || (rest == halfway && (mantissa & 1u)))
+			mantissa++;
+		return sign | static_cast<uint16_t>(mantissa);
+	}
+
+	uint32_t result = (static_cast<uint32_t>(exponent + 15) << 10) | ((mantissa >> 13) & 0x3FFu);
+	const uint32_t rest = mantissa & 0x1FFFu;
+	if (rest > 0x1000u || (rest == 0x1000u && (result & 1u)))
+		result++; // a mantissza tlcsordulsa helyesen a kitevbe lp
+	return sign | static_cast<uint16_t>(result);
+}
+
+ChromaWriter::ChromaWriter(const std::string& path, const bool half, const unsigned sampleRate, const unsigned hop, const unsigned windowSize, const float referencePitch)
+	: half(half), sampleRate(sampleRate), hop(hop), windowSize(windowSize), referencePitch(referencePitch), filled(BlockCount), recycled(BlockCount)
+{
+	file = std::fopen(path.c_str(), "wb");
+	if (!file)
+		throw std::runtime_error("Cannot create chromagram file " + path);
+
+	fileBuffer.resize(1 << 20);
+	std::setvbuf(file, fileBuffer.data(), _IOFBF, fileBuffer.size());
+	if (!WriteHeader())
+	{
+		std::fclose(file);
+		throw std::runtime_error("Cannot write chromagram file " + path);
+	}
+
+	for (size_t i = 0; i < BlockCount; i++)
+	{
+		Block block;
+		block.Frames.reserve(BlockFrames);
+		recycled.TryPush(block);
+	}
+
+	writer = std::thread(&ChromaWriter::WriteLoop, this);
+}
+
+ChromaWriter::~ChromaWriter()
+{
+	Close();
+}
+
+// NumPy 1.0 fejlc: "\x93NUMPY", verzi, 2 bjtos hossz, majd a szkzkkel kitlttt, soremelssel
+// zrul ler, hogy a teljes fejlc HeaderSize bjt legyen.
+bool ChromaWriter::WriteHeader()
+{
+	char description[HeaderSize];
+	const int length = std::snprintf(description, sizeof(description),
+		"{'descr': '%s', 'fortran_order': False, 'shape': (%10llu, 12), } # sr=%u hop=%u win=%u ref=%.2f",
+		half ? "<f2" : "<f4", static_cast<unsigned long long>(frameCount), sampleRate, hop, windowSize, referencePitch);
+
+	const size_t descriptionSize = HeaderSize - 10;
+	std::string header("\x93NUMPY\x01\x00", 8);
+	header += static_cast<char>(descriptionSize & 0xFF);
+	header += static_cast<char>(descriptionSize >> 8);
+	header.append(description, std::min<size_t>(static_cast<size_t>(std::max(length, 0)), descriptionSize - 1));
+	header.resize(HeaderSize - 1, ' ');
+	header += '\n';
+
+	return std::fseek(file, 0, SEEK_SET) == 0
+		&& std::fwrite(header.data(), 1, header.size(), file) == header.size();
+}
+
+// Ha az r lemaradt, alv vrakozssal megvrjuk, amg felszabadul egy blokk. A sorokat csak a
+// Close() utni szllells zrja le, addig a Pop/Push mindig sikeres.
+void ChromaWriter::AcquireBlock(Block& block)
+{
+	recycled.Pop(block);
+	block.Frames.clear();
+	block.End = false;
+}
+
+void ChromaWriter::SubmitBlock(Block& block)
+{
+	filled.Push(block);
+}
+
+void ChromaWriter::Write(const ChromaFrame* frames, const size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		if (!holdingBlock)
+		{
+			AcquireBlock(current);
+			holdingBlock = true;
+		}
+
+		current.Frames.push_back(frames[i].Chroma);
+		if (current.Frames.size() == BlockFrames)
+		{
+			SubmitBlock(current);
+			holdingBlock = false;
+		}
+	}
+	frameCount += count;
+}
+
+void ChromaWriter::WriteLoop()
+{
+	std::vector<uint16_t> encoded(BlockFrames * 12);
+	Block block;
+	bool failed = false;
+	while (filled.Pop(block))
+	{
+		const size_t count = block.Frames.size();
+		// A hiba utn a blokkokat csak visszaadjuk, hogy az elemz szl ne akadjon el.
+		if (!failed)
+		{
+			if (half)
+			{
+				for (size_t f = 0; f < count; f++)
+				{
+					const PitchHistogram& chroma = block.Frames[f];
+					const float peak = *std::max_element(chroma.begin(), chroma.end());
+					const float scale = peak > 0.0f ? 1.0f / peak : 0.0f;
+					for (size_t i = 0; i < 12; i++)
+						encoded[f * 12 + i] = ToHalf(chroma[i] * scale);
+				}
+				failed = std::fwrite(encoded.data(), sizeof(uint16_t), count * 12, file) != count * 12;
+			}
+			else if (count > 0)
+				failed = std::fwrite(block.Frames.data(), sizeof(PitchHistogram), count, file) != count;
+		}
+
+		const bool end = block.End;
+		recycled.Push(block);
+		if (end)
+			break;
+	}
+	writeFailed = failed;
+}
+
+bool ChromaWriter::Close()
+{
+	if (closed)
+		return succeeded;
+	closed = true;
+
+	// A flig telt blokk a vgjelzvel egytt megy t.
+	if (!holdingBlock)
+		AcquireBlock(current);
+	current.End = true;
+	SubmitBlock(current);
+	holdingBlock = false;
+	writer.join();
+
+	succeeded = !writeFailed;
+	if (succeeded)
+		succeeded = WriteHeader();
+	if (std::fclose(file) != 0)
+		succeeded = false;
+	file = nullptr;
+	return succeeded;
+}
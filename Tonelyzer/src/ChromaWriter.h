@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <cstdio>
+#include <thread>
+
+#include "Structures.h"
+#include "SpscQueue.h"
+
+// Ablakonknti hangosztly-vektorok (kromagram) kirsa NumPy .npy (1.0) formtumban: egy rgztett,
+// 128 bjtos fejlc utn frames x 12 float32 vagy float16 rtk, sorfolytonosan. A fejlc a NumPy
+// lern tl egy megjegyzsben a mintavteli frekvencit, a lpskzt, az ablakmretet s a
+// referencia-hangmagassgot is tartalmazza; az adatok mindig a 128. bjttl kezddnek, gy a fjl
+// kzvetlenl lekpezhet (numpy.load(..., mmap_mode='r') vagy sajt olvasval).
+// A kdols s a fjlrs kln szlon fut: az elemz szl csak blokkokba msolja a vektorokat,
+// s egy egytermels-egyfogyaszts soron adja t ket; tele, ill. res sornl a szlak alszanak.
+// Az r szl az els sikertelen rs utn a tovbbi blokkokat eldobja, a hibt a Close() jelzi.
+// float16 esetn minden vektor a legnagyobb elemre normldik, mert a nyers amplitd-sszegek
+// tllpnk a flpontos tartomnyt.
+class ChromaWriter
+{
+public:
+	static const size_t HeaderSize = 128;
+
+	ChromaWriter(const std::string& path, const bool half, const unsigned sampleRate, const unsigned hop, const unsigned windowSize, const float referencePitch);
+	~ChromaWriter();
+
+	ChromaWriter(const ChromaWriter&) = delete;
+	ChromaWriter& operator=(const ChromaWriter&) = delete;
+
+	// Csak az elemz szlrl hvhat
+	void Write(const ChromaFrame* frames, const size_t count);
+
+	// A maradk kirsa, az r szl lelltsa s a fejlc vglegestse a kpkockaszmmal.
+	// false, ha brmelyik rs (vagy a fjl lezrsa) sikertelen volt; a fjl ekkor hinyos.
+	bool Close();
+
+	inline size_t GetFrameCount() const { return frameCount; }
+	// A Close() eltt hvva a vglegestett fejlc ezt a referencia-hangmagassgot tartalmazza.
+	inline void SetReferencePitch(const float pitch) { referencePitch = pitch; }
+
+private:
+	static const size_t BlockFrames = 1024;
+	static const size_t BlockCount = 4;
+
+	struct Block
+	{
+		std::vector<PitchHistogram> Frames;
+		bool End = false;
+	};
+
+	void WriteLoop();
+	bool WriteHeader();
+	void AcquireBlock(Block& block);
+	void SubmitBlock(Block& block);
+
+	FILE* file = nullptr;
+	std::vector<char> fileBuffer;
+	bool half;
+	unsigned sampleRate;
+	unsigned hop;
+	unsigned windowSize;
+	float referencePitch;
+	size_t frameCount = 0; // az elemz szl ltal tadott kpkockk
+
+	SpscQueue<Block> filled;   // elemz -> r
+	SpscQueue<Block> recycled; // r -> elemz (res blokkok)
+	Block current;
+	bool holdingBlock = false;
+	bool closed = false;
+	bool succeeded = true;
+	std::atomic<bool> writeFailed{ false }; // az r szl lltja
+
+	std::thread writer;
+};
@@ -0,0 +1,152 @@
+#include "Decimator.h"
+#include "Simd.h"
+
+// A szr tervezsi paramterei: a zr tartomny csillaptsa dB-ben s a Kaiser-ablak bta rtke.
+static const double StopbandAttenuation = 80.0;
+static const double KaiserBeta = 0.1102 * (StopbandAttenuation - 8.7);
+
+// Mdostott nulladrend Bessel-fggvny (I0) hatvnysorral, a Kaiser-ablakhoz
+static double BesselI0(const double x)
+{
+	double sum = 1.0, term = 1.0;
+	for (int k = 1; k < 50; k++)
+	{
+		term *= (x / (2.0 * k)) * (x / (2.0 * k));
+		sum += term;
+		if (term < sum * 1e-12)
+			break;
+	}
+	return sum;
+}
+
+unsigned Decimator::GetFactor(const unsigned sampleRate)
+{
+	unsigned factor = 1;
+	while (sampleRate / (factor * 2) >= TargetSampleRate)
+		factor *= 2;
+	return factor;
+}
+
+Decimator::Decimator(const unsigned sampleRate)
+	: sampleRate(sampleRate), factor(GetFactor(sampleRate))
+{
+	if (factor == 1)
+		return;
+
+	// Az tereszt sv MaxAnalysisFrequency-ig tart. A zr sv ott kezddik, ahonnan a tkrzds
+	// mr MaxAnalysisFrequency fl esik (kimeneti fs - MaxAnalysisFrequency), gy az tmeneti
+	// svba es tkrztt komponensek nem kerlnek az elemzett tartomnyba.
+	const double outputRate = static_cast<double>(sampleRate) / factor;
+	const double passEdge = MaxAnalysisFrequency;
+	const double stopEdge = outputRate - MaxAnalysisFrequency;
+	const double cutoff = (passEdge + stopEdge) / 2.0 / sampleRate; // normlt, ciklus/minta
+	const double transition = 2.0 * 3.14159265358979323846 * (stopEdge - passEdge) / sampleRate;
+
+	// Kaiser-fle becsls a szr hosszra, pratlan hosszal (szimmetrikus, egsz ksleltets FIR)
+	size_t length = static_cast<size_t>(std::ceil((StopbandAttenuation - 8.0) / (2.285 * transition))) + 1;
+	length |= 1;
+
+	taps.resize(length);
+	const double center = (length - 1) / 2.0;
+	const double norm = BesselI0(KaiserBeta);
+	double sum = 0.0;
+	for (size_t n = 0; n < length; n++)
+	{
+		const double t = n - center;
+		const double sinc = t == 0.0 ? 2.0 * cutoff : std::sin(2.0 * 3.14159265358979323846 * cutoff * t) / (3.14159265358979323846 * t);
+		const double r = t / center;
+		const double window = BesselI0(KaiserBeta * std::sqrt(std::max(0.0, 1.0 - r * r))) / norm;
+		taps[n] = static_cast<float>(sinc * window);
+		sum += taps[n];
+	}
+
+	// Egysgnyi egyenram ersts
+	for (float& tap : taps)
+		tap = static_cast<float>(tap / sum);
+}
+
+static float DotScalar(const float* x, const float* h, const size_t length)
+{
+	float sum = 0.0f;
+	for (size_t n = 0; n < length; n++)
+		sum += x[n] * h[n];
+	return sum;
+}
+
+#if defined(TONELYZER_X86_SIMD)
+
+static float DotSse2(const float* x, const float* h, const size_t length)
+{
+	__m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+	size_t n = 0;
+	for (; n + 8 <= length; n += 8)
+	{
+		acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(x + n), _mm_loadu_ps(h + n)));
+		acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(x + n + 4), _mm_loadu_ps(h + n + 4)));
+	}
+
+	float lanes[4];
+	_mm_storeu_ps(lanes, _mm_add_ps(acc0, acc1));
+	float sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+	for (; n < length; n++)
+		sum += x[n] * h[n];
+	return sum;
+}
+
+// AVX2 + FMA: kt fggetlen akkumultor, hogy az FMA ksleltetse elrejthet legyen.
+TONELYZER_TARGET_AVX2
+static float DotAvx2(const float* x, const float* h, const size_t length)
+{
+	__m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+	size_t n = 0;
+	for (; n + 16 <= length; n += 16)
+	{
+		acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(x + n), _mm256_loadu_ps(h + n), acc0);
+		acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(x + n + 8), _mm256_loadu_ps(h + n + 8), acc1);
+	}
+
+	float lanes[8];
+	_mm256_storeu_ps(lanes, _mm256_add_ps(acc0, acc1));
+	float sum = ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+	for (; n < length; n++)
+		sum += x[n] * h[n];
+	return sum;
+}
+
+#endif
+
+void Decimator::Process(const float* input, const size_t count, std::vector<float>& output)
+{
+	if (factor == 1)
+	{
+		output.insert(output.end(), input, input + count);
+		return;
+	}
+
+	pending.insert(pending.end(), input, input + count);
+
+	float (*dot)(const float*, const float*, size_t) = DotScalar;
+#if defined(TONELYZER_X86_SIMD)
+	const CpuFeatures& cpu = GetCpuFeatures();
+	dot = (cpu.AVX2 && cpu.FMA) ? DotAvx2 : DotSse2;
+#endif
+
+	// A szr szimmetrikus, gy a konvolci a bemenet s az egytthatk skalrszorzata.
+	// Csak minden factor-adik kimeneti mintt szmoljuk ki.
+	const size_t length = taps.size();
+	size_t position = 0;
+	for (; position + length <= pending.size(); position += factor)
+		output.push_back(dot(pending.data() + position, taps.data(), length));
+
+	pending.erase(pending.begin(), pending.begin() + std::min(position, pending.size()));
+}
+
+void Decimator::Apply(AudioData& data)
+{
+	std::vector<float> decimated;
+	decimated.reserve(data.MonoData.size() / factor + 1);
+	Process(data.MonoData.data(), data.MonoData.size(), decimated);
+
+	data.MonoData = std::move(decimated);
+	data.SampleRate = GetOutputSampleRate();
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <memory>
+
+#include "Structures.h"
+
+// lsimt (anti-aliasing) alul-tereszt szrs s alulmintavtelezs a transzformci eltt.
+// Az elemzs csak MaxAnalysisFrequency alatti tartomnyt hasznl, ezrt a jelet a lehet
+// legnagyobb, kett hatvny tnyezvel ritktjuk gy, hogy a kimeneti mintavteli frekvencia
+// legalbb TargetSampleRate maradjon (44.1 kHz -> 11025 Hz, 48/96 kHz -> 12 kHz).
+// A FIR szrt csak a megtartott kimeneti mintkra rtkeljk ki (polifzis felbonts),
+// gy a szmts a kimeneti mintavteli frekvencival arnyos.
+class Decimator
+{
+public:
+	static const unsigned TargetSampleRate = 11025;
+
+	Decimator(const unsigned sampleRate);
+
+	// Blokkonknti feldolgozs: a bemenet vgrl a kvetkez blokkhoz szksges mintk megmaradnak,
+	// a kimeneti mintk az output vghez fzdnek.
+	void Process(const float* input, const size_t count, std::vector<float>& output);
+
+	// A mg fel nem dolgozott mintk eldobsa (j, nem folytatlagos szakasz eltt).
+	inline void Reset() { pending.clear(); }
+
+	// A teljes mon jel ritktsa helyben, a SampleRate frisstsvel.
+	void Apply(AudioData& data);
+
+	inline unsigned GetFactor() const { return factor; }
+	inline unsigned GetOutputSampleRate() const { return sampleRate / factor; }
+
+	static unsigned GetFactor(const unsigned sampleRate);
+
+private:
+	unsigned sampleRate;
+	unsigned factor;
+	std::vector<float> taps;
+	std::vector<float> pending; // mg fel nem dolgozott bemeneti mintk
+};
@@ -0,0 +1,129 @@
+#include "Downmixer.h"
+#include "Simd.h"
+
+Downmixer::Downmixer(const unsigned channels, const DownmixSettings& settings)
+	: channels(channels), weights(GetWeights(channels, settings))
+{
+}
+
+std::vector<float> Downmixer::GetWeights(const unsigned channels, const DownmixSettings& settings)
+{
+	std::vector<float> result(channels, 1.0f);
+
+	if (settings.Type == DownmixType::Custom)
+	{
+		// A megadott slyokat vltozatlanul hasznljuk (a lekevert jel sklja az elemzst nem befolysolja).
+		if (settings.Weights.size() == channels)
+			return settings.Weights;
+		else
+			std::cerr << "The -mix weight list has " << settings.Weights.size() << " values for " << channels << " channels, using the average." << std::endl;
+	}
+	else if (settings.Type == DownmixType::Itu && (channels == 6 || channels == 8))
+	{
+		// ITU-R BS.775 szerinti lekevers WAV csatornasorrendben (FL FR FC LFE BL BR [SL SR]):
+		// a kzps s a trhats csatornk -3 dB-lel, az LFE kimarad.
+		const float minus3dB = 0.70710678f;
+		for (unsigned c = 2; c < channels; c++)
+			result[c] = minus3dB;
+		result[3] = 0.0f;
+	}
+
+	float sum = 0.0f;
+	for (const float w : result)
+		sum += w;
+	if (sum > 0.0f)
+		for (float& w : result)
+			w /= sum;
+
+	return result;
+}
+
+static void DownmixScalar(const float* x, const size_t frames, const unsigned channels, const float* w, float* mono)
+{
+	for (size_t i = 0; i < frames; i++)
+	{
+		const float* frame = x + i * channels;
+		float sum = 0.0f;
+		for (unsigned c = 0; c < channels; c++)
+			sum += frame[c] * w[c];
+		mono[i] = sum;
+	}
+}
+
+#if defined(TONELYZER_X86_SIMD)
+
+// Sztere: kt regiszternyi (L R L R ...) mintbl pros/pratlan sztvlogatssal bal s jobb csatorna.
+static size_t DownmixStereoSse2(const float* x, const size_t frames, const float* w, float* mono)
+{
+	const __m128 wl = _mm_set1_ps(w[0]), wr = _mm_set1_ps(w[1]);
+	size_t i = 0;
+	for (; i + 4 <= frames; i += 4)
+	{
+		const __m128 a = _mm_loadu_ps(x + 2 * i);
+		const __m128 b = _mm_loadu_ps(x + 2 * i + 4);
+		const __m128 left = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+		const __m128 right = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+		_mm_storeu_ps(mono + i, _mm_add_ps(_mm_mul_ps(left, wl), _mm_mul_ps(right, wr)));
+	}
+	return i;
+}
+
+TONELYZER_TARGET_AVX2
+static size_t DownmixStereoAvx2(const float* x, const size_t frames, const float* w, float* mono)
+{
+	const __m256 wl = _mm256_set1_ps(w[0]), wr = _mm256_set1_ps(w[1]);
+	size_t i = 0;
+	for (; i + 8 <= frames; i += 8)
+	{
+		const __m256 a = _mm256_loadu_ps(x + 2 * i);
+		const __m256 b = _mm256_loadu_ps(x + 2 * i + 8);
+		// 128 bites svonknti sztvlogats, majd a 64 bites negyedek sorrendjnek helyrelltsa
+		const __m256 left = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0))), _MM_SHUFFLE(3, 1, 2, 0)));
+		const __m256 right = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1))), _MM_SHUFFLE(3, 1, 2, 0)));
+		_mm256_storeu_ps(mono + i, _mm256_add_ps(_mm256_mul_ps(left, wl), _mm256_mul_ps(right, wr)));
+	}
+	return i;
+}
+
+// ltalnos eset: csatornnknt egy gather 8 kpkockrl (index: kpkocka * channels + c).
+TONELYZER_TARGET_AVX2
+static size_t DownmixGatherAvx2(const float* x, const size_t frames, const unsigned channels, const float* w, float* mono)
+{
+	const __m256i stride = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(static_cast<int>(channels)));
+	size_t i = 0;
+	for (; i + 8 <= frames; i += 8)
+	{
+		const float* block = x + i * channels;
+		__m256 sum = _mm256_mul_ps(_mm256_i32gather_ps(block, stride, 4), _mm256_set1_ps(w[0]));
+		for (unsigned c = 1; c < channels; c++)
+			sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_i32gather_ps(block + c, stride, 4), _mm256_set1_ps(w[c])));
+		_mm256_storeu_ps(mono + i, sum);
+	}
+	return i;
+}
+
+#endif
+
+void Downmixer::Process(const float* interleaved, const size_t frames, float* mono) const
+{
+	const float* w = weights.data();
+	size_t done = 0;
+
+	if (channels == 1)
+	{
+		for (size_t i = 0; i < frames; i++)
+			mono[i] = interleaved[i] * w[0];
+		return;
+	}
+
+#if defined(TONELYZER_X86_SIMD)
+	const CpuFeatures& cpu = GetCpuFeatures();
+	if (channels == 2)
+		done = cpu.AVX2 ? DownmixStereoAvx2(interleaved, frames, w, mono) : DownmixStereoSse2(interleaved, frames, w, mono);
+	else if (cpu.AVX2)
+		done = DownmixGatherAvx2(interleaved, frames, channels, w, mono);
+#endif
+
+	// A maradk (s SIMD nlkl az sszes) kpkocka skalrisan
+	DownmixScalar(interleaved + done * channels, frames - done, channels, w, mono + done);
+}
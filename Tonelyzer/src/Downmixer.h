@@ -0,0 +1,25 @@
+#pragma once
+
+#include "Structures.h"
+
+// Tetszleges csatornaszm, tlapolt (interleaved) blokk monv keverse csatornnknti slyokkal.
+// A dekdols blokkjain fut, gy a teljes tlapolt jel sosem kerl a memriba. A szmts a
+// kpkockk mentn vektorizlt: AVX2 alatt 8, SSE2 alatt 4 kpkocka egyszerre.
+class Downmixer
+{
+public:
+	Downmixer(const unsigned channels, const DownmixSettings& settings = DownmixSettings());
+
+	// frames darab kpkocka (frames * channels minta) -> frames darab mon minta
+	void Process(const float* interleaved, const size_t frames, float* mono) const;
+
+	inline unsigned GetChannels() const { return channels; }
+	inline const std::vector<float>& GetWeights() const { return weights; }
+
+	// A bellts s a csatornaszm alapjn szmolt slyok (az elre definilt mdokban sszegk 1)
+	static std::vector<float> GetWeights(const unsigned channels, const DownmixSettings& settings);
+
+private:
+	unsigned channels;
+	std::vector<float> weights;
+};
@@ -0,0 +1,220 @@
+#include <atomic>
+
+#include "FFTKernels.h"
+#include "Simd.h"
+
+static std::atomic<int> kernelPath(static_cast<int>(FFTKernels::KernelPath::Auto));
+
+// A tnylegesen hasznlt kdt: a rgztett, vagy a processzor ltal tmogatott legjobb
+static FFTKernels::KernelPath GetActivePath()
+{
+	const FFTKernels::KernelPath path = static_cast<FFTKernels::KernelPath>(kernelPath.load());
+	if (path != FFTKernels::KernelPath::Auto)
+		return path;
+	if (FFTKernels::IsAvailable(FFTKernels::KernelPath::Avx2))
+		return FFTKernels::KernelPath::Avx2;
+	if (FFTKernels::IsAvailable(FFTKernels::KernelPath::Sse2))
+		return FFTKernels::KernelPath::Sse2;
+	return FFTKernels::KernelPath::Scalar;
+}
+
+void FFTKernels::Radix2Stage(float* re, float* im, const size_t size)
+{
+	for (size_t s = 0; s < size; s += 2)
+	{
+		const float ar = re[s], ai = im[s];
+		const float br = re[s + 1], bi = im[s + 1];
+		re[s]     = ar + br;
+		im[s]     = ai + bi;
+		re[s + 1] = ar - br;
+		im[s + 1] = ai - bi;
+	}
+}
+
+// Skalr 4 pontos pillang: b, c, d forgatsa w^2, w^1, w^3 tnyezkkel, majd
+// a kt sszevont radix-2 lpcs sszeadsai. A -i/+i szorzs csak csere s eljelvlts.
+static void Radix4StageScalar(float* re, float* im, const size_t size, const size_t quarter, const float* tw)
+{
+	const float* w1r = tw;
+	const float* w1i = tw + quarter;
+	const float* w2r = tw + 2 * quarter;
+	const float* w2i = tw + 3 * quarter;
+	const float* w3r = tw + 4 * quarter;
+	const float* w3i = tw + 5 * quarter;
+
+	for (size_t s = 0; s < size; s += 4 * quarter)
+	{
+		float* r0 = re + s;                 float* i0 = im + s;
+		float* r1 = r0 + quarter;           float* i1 = i0 + quarter;
+		float* r2 = r0 + 2 * quarter;       float* i2 = i0 + 2 * quarter;
+		float* r3 = r0 + 3 * quarter;       float* i3 = i0 + 3 * quarter;
+
+		for (size_t k = 0; k < quarter; k++)
+		{
+			const float ar = r0[k], ai = i0[k];
+			const float br = r1[k] * w2r[k] - i1[k] * w2i[k];
+			const float bi = r1[k] * w2i[k] + i1[k] * w2r[k];
+			const float cr = r2[k] * w1r[k] - i2[k] * w1i[k];
+			const float ci = r2[k] * w1i[k] + i2[k] * w1r[k];
+			const float dr = r3[k] * w3r[k] - i3[k] * w3i[k];
+			const float di = r3[k] * w3i[k] + i3[k] * w3r[k];
+
+			const float t0r = ar + br, t0i = ai + bi;
+			const float t1r = ar - br, t1i = ai - bi;
+			const float t2r = cr + dr, t2i = ci + di;
+			const float t3r = cr - dr, t3i = ci - di;
+
+			r0[k] = t0r + t2r; i0[k] = t0i + t2i;
+			r2[k] = t0r - t2r; i2[k] = t0i - t2i;
+			r1[k] = t1r + t3i; i1[k] = t1i - t3r;
+			r3[k] = t1r - t3i; i3[k] = t1i + t3r;
+		}
+	}
+}
+
+#if defined(TONELYZER_X86_SIMD)
+
+// SSE2: 4 pillang egyszerre, quarter >= 4 esetn.
+static void Radix4StageSse2(float* re, float* im, const size_t size, const size_t quarter, const float* tw)
+{
+	const float* w1r = tw;
+	const float* w1i = tw + quarter;
+	const float* w2r = tw + 2 * quarter;
+	const float* w2i = tw + 3 * quarter;
+	const float* w3r = tw + 4 * quarter;
+	const float* w3i = tw + 5 * quarter;
+
+	for (size_t s = 0; s < size; s += 4 * quarter)
+	{
+		float* r0 = re + s;                 float* i0 = im + s;
+		float* r1 = r0 + quarter;           float* i1 = i0 + quarter;
+		float* r2 = r0 + 2 * quarter;       float* i2 = i0 + 2 * quarter;
+		float* r3 = r0 + 3 * quarter;       float* i3 = i0 + 3 * quarter;
+
+		for (size_t k = 0; k < quarter; k += 4)
+		{
+			const __m128 ar = _mm_loadu_ps(r0 + k), ai = _mm_loadu_ps(i0 + k);
+
+			__m128 xr = _mm_loadu_ps(r1 + k), xi = _mm_loadu_ps(i1 + k);
+			__m128 wr = _mm_loadu_ps(w2r + k), wi = _mm_loadu_ps(w2i + k);
+			const __m128 br = _mm_sub_ps(_mm_mul_ps(xr, wr), _mm_mul_ps(xi, wi));
+			const __m128 bi = _mm_add_ps(_mm_mul_ps(xr, wi), _mm_mul_ps(xi, wr));
+
+			xr = _mm_loadu_ps(r2 + k); xi = _mm_loadu_ps(i2 + k);
+			wr = _mm_loadu_ps(w1r + k); wi = _mm_loadu_ps(w1i + k);
+			const __m128 cr = _mm_sub_ps(_mm_mul_ps(xr, wr), _mm_mul_ps(xi, wi));
+			const __m128 ci = _mm_add_ps(_mm_mul_ps(xr, wi), _mm_mul_ps(xi, wr));
+
+			xr = _mm_loadu_ps(r3 + k); xi = _mm_loadu_ps(i3 + k);
+			wr = _mm_loadu_ps(w3r + k); wi = _mm_loadu_ps(w3i + k);
+			const __m128 dr = _mm_sub_ps(_mm_mul_ps(xr, wr), _mm_mul_ps(xi, wi));
+			const __m128 di = _mm_add_ps(_mm_mul_ps(xr, wi), _mm_mul_ps(xi, wr));
+
+			const __m128 t0r = _mm_add_ps(ar, br), t0i = _mm_add_ps(ai, bi);
+			const __m128 t1r = _mm_sub_ps(ar, br), t1i = _mm_sub_ps(ai, bi);
+			const __m128 t2r = _mm_add_ps(cr, dr), t2i = _mm_add_ps(ci, di);
+			const __m128 t3r = _mm_sub_ps(cr, dr), t3i = _mm_sub_ps(ci, di);
+
+			_mm_storeu_ps(r0 + k, _mm_add_ps(t0r, t2r)); _mm_storeu_ps(i0 + k, _mm_add_ps(t0i, t2i));
+			_mm_storeu_ps(r2 + k, _mm_sub_ps(t0r, t2r)); _mm_storeu_ps(i2 + k, _mm_sub_ps(t0i, t2i));
+			_mm_storeu_ps(r1 + k, _mm_add_ps(t1r, t3i)); _mm_storeu_ps(i1 + k, _mm_sub_ps(t1i, t3r));
+			_mm_storeu_ps(r3 + k, _mm_sub_ps(t1r, t3i)); _mm_storeu_ps(i3 + k, _mm_add_ps(t1i, t3r));
+		}
+	}
+}
+
+// AVX2 + FMA: 8 pillang egyszerre, quarter >= 8 esetn.
+TONELYZER_TARGET_AVX2
+static void Radix4StageAvx2(float* re, float* im, const size_t size, const size_t quarter, const float* tw)
+{
+	const float* w1r = tw;
+	const float* w1i = tw + quarter;
+	const float* w2r = tw + 2 * quarter;
+	const float* w2i = tw + 3 * quarter;
+	const float* w3r = tw + 4 * quarter;
+	const float* w3i = tw + 5 * quarter;
+
+	for (size_t s = 0; s < size; s += 4 * quarter)
+	{
+		float* r0 = re + s;                 float* i0 = im + s;
+		float* r1 = r0 + quarter;           float* i1 = i0 + quarter;
+		float* r2 = r0 + 2 * quarter;       float* i2 = i0 + 2 * quarter;
+		float* r3 = r0 + 3 * quarter;       float* i3 = i0 + 3 * quarter;
+
+		for (size_t k = 0; k < quarter; k += 8)
+		{
+			const __m256 ar = _mm256_loadu_ps(r0 + k), ai = _mm256_loadu_ps(i0 + k);
+
+			__m256 xr = _mm256_loadu_ps(r1 + k), xi = _mm256_loadu_ps(i1 + k);
+			__m256 wr = _mm256_loadu_ps(w2r + k), wi = _mm256_loadu_ps(w2i + k);
+			const __m256 br = _mm256_fmsub_ps(xr, wr, _mm256_mul_ps(xi, wi));
+			const __m256 bi = _mm256_fmadd_ps(xr, wi, _mm256_mul_ps(xi, wr));
+
+			xr = _mm256_loadu_ps(r2 + k); xi = _mm256_loadu_ps(i2 + k);
+			wr = _mm256_loadu_ps(w1r + k); wi = _mm256_loadu_ps(w1i + k);
+			const __m256 cr = _mm256_fmsub_ps(xr, wr, _mm256_mul_ps(xi, wi));
+			const __m256 ci = _mm256_fmadd_ps(xr, wi, _mm256_mul_ps(xi, wr));
+
+			xr = _mm256_loadu_ps(r3 + k); xi = _mm256_loadu_ps(i3 + k);
+			wr = _mm256_loadu_ps(w3r + k); wi = _mm256_loadu_ps(w3i + k);
+			const __m256 dr = _mm256_fmsub_ps(xr, wr, _mm256_mul_ps(xi, wi));
+			const __m256 di = _mm256_fmadd_ps(xr, wi, _mm256_mul_ps(xi, wr));
+
+			const __m256 t0r = _mm256_add_ps(ar, br), t0i = _mm256_add_ps(ai, bi);
+			const __m256 t1r = _mm256_sub_ps(ar, br), t1i = _mm256_sub_ps(ai, bi);
+			const __m256 t2r = _mm256_add_ps(cr, dr), t2i = _mm256_add_ps(ci, di);
+			const __m256 t3r = _mm256_sub_ps(cr, dr), t3i = _mm256_sub_ps(ci, di);
+
+			_mm256_storeu_ps(r0 + k, _mm256_add_ps(t0r, t2r)); _mm256_storeu_ps(i0 + k, _mm256_add_ps(t0i, t2i));
+			_mm256_storeu_ps(r2 + k, _mm256_sub_ps(t0r, t2r)); _mm256_storeu_ps(i2 + k, _mm256_sub_ps(t0i, t2i));
+			_mm256_storeu_ps(r1 + k, _mm256_add_ps(t1r, t3i)); _mm256_storeu_ps(i1 + k, _mm256_sub_ps(t1i, t3r));
+			_mm256_storeu_ps(r3 + k, _mm256_sub_ps(t1r, t3i)); _mm256_storeu_ps(i3 + k, _mm256_add_ps(t1i, t3r));
+		}
+	}
+}
+
+#endif
+
+void FFTKernels::Radix4Stage(float* re, float* im, const size_t size, const size_t quarter, const float* tw)
+{
+#if defined(TONELYZER_X86_SIMD)
+	const KernelPath path = GetActivePath();
+	if (path == KernelPath::Avx2 && quarter % 8 == 0)
+		return Radix4StageAvx2(re, im, size, quarter, tw);
+	if ((path == KernelPath::Avx2 || path == KernelPath::Sse2) && quarter % 4 == 0)
+		return Radix4StageSse2(re, im, size, quarter, tw);
+#endif
+	Radix4StageScalar(re, im, size, quarter, tw);
+}
+
+bool FFTKernels::IsAvailable(const KernelPath path)
+{
+#if defined(TONELYZER_X86_SIMD)
+	const CpuFeatures& cpu = GetCpuFeatures();
+	if (path == KernelPath::Avx2)
+		return cpu.AVX2 && cpu.FMA;
+	if (path == KernelPath::Sse2)
+		return cpu.SSE2;
+	return true;
+#else
+	return path == KernelPath::Auto || path == KernelPath::Scalar;
+#endif
+}
+
+bool FFTKernels::SetKernelPath(const KernelPath path)
+{
+	if (!IsAvailable(path))
+		return false;
+	kernelPath = static_cast<int>(path);
+	return true;
+}
+
+const char* FFTKernels::GetKernelName()
+{
+	switch (GetActivePath())
+	{
+	case KernelPath::Avx2: return "avx2";
+	case KernelPath::Sse2: return "sse2";
+	default: return "scalar";
+	}
+}
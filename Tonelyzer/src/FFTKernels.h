@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+
+// Az FFT pillang-lpcsi sztvlasztott (SoA) vals/kpzetes tmbkn.
+// Futsidben vlaszt az AVX2, SSE2 s skalr megvalsts kzl.
+class FFTKernels
+{
+public:
+	// Kettes lpcs egysgnyi forgatsi tnyezkkel (a bitfordts utni els lpcs).
+	static void Radix2Stage(float* re, float* im, const size_t size);
+
+	// Ngyes lpcs; tw: quarter hossz w1re, w1im, w2re, w2im, w3re, w3im blokkok egyms utn.
+	static void Radix4Stage(float* re, float* im, const size_t size, const size_t quarter, const float* tw);
+
+	// Kdt: Auto a processzor legjobbja; a tbbi rgzti a megvalstst (ellenrzshez, mrshez).
+	enum class KernelPath { Auto, Scalar, Sse2, Avx2 };
+
+	// A processzoron nem futtathat kdutat nem lltja be (hamis).
+	static bool SetKernelPath(const KernelPath path);
+	static bool IsAvailable(const KernelPath path);
+	static const char* GetKernelName();
+};
@@ -0,0 +1,222 @@
+#include "FFTPlan.h"
+#include "FFTKernels.h"
+
+FFTPlan::FFTPlan(const size_t size)
+	: size(size), oddLog2(false)
+{
+	if (size == 0 || (size & (size - 1)) != 0)
+		throw std::invalid_argument("FFT plan size must be a power of two!");
+
+	unsigned log2Size = 0;
+	while ((static_cast<size_t>(1) << log2Size) < size)
+		log2Size++;
+	oddLog2 = (log2Size % 2) == 1;
+
+	// Bitfordtsos permutci indextblja
+	bitReversal.resize(size);
+	for (size_t i = 0; i < size; i++)
+	{
+		size_t j = 0;
+		for (unsigned b = 0; b < log2Size; b++)
+			if (i & (static_cast<size_t>(1) << b))
+				j |= static_cast<size_t>(1) << (log2Size - 1 - b);
+
+		bitReversal[i] = static_cast<unsigned>(j);
+	}
+
+	// Radix-4 lpcsnknt egyms utn trolt w^1, w^2, w^3 forgatsi tnyezk SoA elrendezsben
+	// (w1re, w1im, w2re, w2im, w3re, w3im blokkok), ahol w = exp(-2*pi*i*k / (4*quarter)).
+	// Dupla pontossggal szmolva.
+	for (size_t quarter = oddLog2 ? 2 : 1; quarter * 4 <= size; quarter *= 4)
+	{
+		const size_t offset = twiddles.size();
+		twiddles.resize(offset + 6 * quarter);
+
+		for (size_t k = 0; k < quarter; k++)
+		{
+			const double angle = -2.0 * 3.14159265358979323846 * k / (4.0 * quarter);
+			for (int m = 1; m <= 3; m++)
+			{
+				const std::complex<double> w = std::polar(1.0, angle * m);
+				twiddles[offset + (2 * m - 2) * quarter + k] = static_cast<float>(w.real());
+				twiddles[offset + (2 * m - 1) * quarter + k] = static_cast<float>(w.imag());
+			}
+		}
+	}
+}
+
+// Iteratv, helyben (in-place) szmol Cooley-Tukey FFT: bitfordts, majd egy
+// opcionlis radix-2 s utna radix-4 lpcsk. Szmtsi bonyolultsga: O(n*log2(n)).
+void FFTPlan::Forward(FTdata& data) const
+{
+	if (data.size() != size)
+		throw std::invalid_argument("FFT input size does not match the plan size!");
+
+	Forward(data.data());
+}
+
+// sszefslt (AoS) adat esetn szlanknt egyszer lefoglalt SoA munkapufferen keresztl.
+void FFTPlan::Forward(std::complex<float>* x) const
+{
+	thread_local SplitFTdata scratch;
+	scratch.Re.resize(size);
+	scratch.Im.resize(size);
+
+	Forward(x, scratch.Re.data(), scratch.Im.data());
+
+	for (size_t i = 0; i < size; i++)
+		x[i] = std::complex<float>(scratch.Re[i], scratch.Im[i]);
+}
+
+// Nem helyben szmol vltozat: a bitfordts a bemenet SoA-ba msolsval egy lpsben
+// trtnik, gy elmarad a cache-kedveztlen helyben cserlgets.
+void FFTPlan::Forward(const std::complex<float>* input, float* re, float* im) const
+{
+	for (size_t i = 0; i < size; i++)
+	{
+		const std::complex<float> v = input[bitReversal[i]];
+		re[i] = v.real();
+		im[i] = v.imag();
+	}
+
+	Stages(re, im);
+}
+
+// Mint fent, de a bemenet vals s kpzetes rszt elemenknt a slyok megfelel rszvel szorozza.
+void FFTPlan::Forward(const std::complex<float>* input, const std::complex<float>* weights, float* re, float* im) const
+{
+	for (size_t i = 0; i < size; i++)
+	{
+		const size_t j = bitReversal[i];
+		re[i] = input[j].real() * weights[j].real();
+		im[i] = input[j].imag() * weights[j].imag();
+	}
+
+	Stages(re, im);
+}
+
+void FFTPlan::Forward(SplitFTdata& data) const
+{
+	if (data.Re.size() != size || data.Im.size() != size)
+		throw std::invalid_argument("FFT input size does not match the plan size!");
+
+	Forward(data.Re.data(), data.Im.data());
+}
+
+void FFTPlan::Forward(float* re, float* im) const
+{
+	for (size_t i = 0; i < size; i++)
+	{
+		const size_t j = bitReversal[i];
+		if (i < j)
+		{
+			std::swap(re[i], re[j]);
+			std::swap(im[i], im[j]);
+		}
+	}
+
+	Stages(re, im);
+}
+
+void FFTPlan::Stages(float* re, float* im) const
+{
+	if (oddLog2)
+		FFTKernels::Radix2Stage(re, im, size);
+
+	const float* tw = twiddles.data();
+	for (size_t quarter = oddLog2 ? 2 : 1; quarter * 4 <= size; quarter *= 4)
+	{
+		FFTKernels::Radix4Stage(re, im, size, quarter, tw);
+		tw += 6 * quarter;
+	}
+}
+
+void FFTPlan::Forward(const FTdata& window, FTdata& result) const
+{
+	result = window;
+	Forward(result);
+}
+
+std::shared_ptr<const FFTPlan> FFTPlan::Get(const size_t size)
+{
+	static std::mutex cacheMutex;
+	static std::map<size_t, std::shared_ptr<const FFTPlan>> cache;
+
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	std::shared_ptr<const FFTPlan>& plan = cache[size];
+	if (!plan)
+		plan = std::make_shared<const FFTPlan>(size);
+	return plan;
+}
+
+RealFFTPlan::RealFFTPlan(const size_t size)
+	: size(size)
+{
+	if (size < 2 || (size & (size - 1)) != 0)
+		throw std::invalid_argument("Real FFT plan size must be a power of two, at least 2!");
+
+	halfPlan = FFTPlan::Get(size / 2);
+
+	// W_n^k = exp(-2*pi*i*k / n), k = 0 .. n/2-1
+	twiddles.resize(size / 2);
+	for (size_t k = 0; k < size / 2; k++)
+	{
+		const std::complex<double> w = std::polar(1.0, -2.0 * 3.14159265358979323846 * k / size);
+		twiddles[k] = std::complex<float>(static_cast<float>(w.real()), static_cast<float>(w.imag()));
+	}
+}
+
+// A kimeneti spektrum n/2+1 elem (0 Hz-tl a Nyquist-frekvenciig).
+void RealFFTPlan::Forward(const float* input, FTdata& spectrum) const
+{
+	Forward(input, nullptr, spectrum);
+}
+
+void RealFFTPlan::Forward(const float* input, const float* weights, FTdata& spectrum) const
+{
+	const size_t half = size / 2;
+	spectrum.resize(half + 1);
+
+	// z[m] = x[2m] + i*x[2m+1]: a vals mintk prjai sszefslt komplex szmknt olvashatk.
+	// Szlanknt egyszer lefoglalt SoA munkapufferbe kerlnek.
+	thread_local SplitFTdata scratch;
+	scratch.Re.resize(half);
+	scratch.Im.resize(half);
+	float* zr = scratch.Re.data();
+	float* zi = scratch.Im.data();
+
+	const std::complex<float>* pairs = reinterpret_cast<const std::complex<float>*>(input);
+	if (weights)
+		halfPlan->Forward(pairs, reinterpret_cast<const std::complex<float>*>(weights), zr, zi);
+	else
+		halfPlan->Forward(pairs, zr, zi);
+
+	// Utfeldolgozs: E = (Z[k] + conj(Z[n/2-k])) / 2, O = (Z[k] - conj(Z[n/2-k])) / 2i,
+	// X[k] = E + W^k * O
+	spectrum[0]    = std::complex<float>(zr[0] + zi[0], 0.0f);
+	spectrum[half] = std::complex<float>(zr[0] - zi[0], 0.0f);
+
+	for (size_t k = 1; k < half; k++)
+	{
+		const float evr = 0.5f * (zr[k] + zr[half - k]);
+		const float evi = 0.5f * (zi[k] - zi[half - k]);
+		const float odr = 0.5f * (zi[k] + zi[half - k]);
+		const float odi = -0.5f * (zr[k] - zr[half - k]);
+
+		const float wr = twiddles[k].real();
+		const float wi = twiddles[k].imag();
+		spectrum[k] = std::complex<float>(evr + wr * odr - wi * odi, evi + wr * odi + wi * odr);
+	}
+}
+
+std::shared_ptr<const RealFFTPlan> RealFFTPlan::Get(const size_t size)
+{
+	static std::mutex cacheMutex;
+	static std::map<size_t, std::shared_ptr<const RealFFTPlan>> cache;
+
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	std::shared_ptr<const RealFFTPlan>& plan = cache[size];
+	if (!plan)
+		plan = std::make_shared<const RealFFTPlan>(size);
+	return plan;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+
+#include "Structures.h"
+
+// Elre kiszmolt FFT-terv egy adott (2 hatvny) ablakmretre.
+// Tartalmazza a forgatsi (twiddle) tnyezket s a bitfordtsos permutcit,
+// gy ablakonknt se memriafoglals, se trigonometrikus fggvnyhvs nem trtnik.
+// Bell sztvlasztott (SoA) vals/kpzetes tmbkn szmol SIMD pillangkkal (FFTKernels).
+class FFTPlan
+{
+public:
+	explicit FFTPlan(const size_t size);
+
+	void Forward(FTdata& data) const;
+	void Forward(const FTdata& window, FTdata& result) const;
+	void Forward(std::complex<float>* data) const;
+	void Forward(SplitFTdata& data) const;
+	void Forward(float* re, float* im) const;
+	void Forward(const std::complex<float>* input, float* re, float* im) const;
+	void Forward(const std::complex<float>* input, const std::complex<float>* weights, float* re, float* im) const;
+
+	inline size_t GetSize() const { return size; }
+
+	// Megosztott, szlbiztos terv-gyorsttr: mretenknt egyszer pl fel a terv.
+	static std::shared_ptr<const FFTPlan> Get(const size_t size);
+
+private:
+	void Stages(float* re, float* im) const;
+
+	size_t size;
+	bool oddLog2;
+	std::vector<unsigned> bitReversal;
+	std::vector<float> twiddles;
+};
+
+// Vals bemenet FFT: n vals mintt n/2 komplex pontba csomagol (pros mintk a vals,
+// pratlanok a kpzetes rszbe), lefuttat egy n/2 mret komplex FFT-t, majd utfeldolgozssal
+// ellltja a spektrum n/2+1 egyedi bin-jt. Kb. fele annyi szmts s memriaforgalom.
+class RealFFTPlan
+{
+public:
+	explicit RealFFTPlan(const size_t size);
+
+	void Forward(const float* input, FTdata& spectrum) const;
+	// Ablakfggvnnyel slyozott bemenet: a szorzs a bemenet beolvassval egy lpsben trtnik.
+	void Forward(const float* input, const float* weights, FTdata& spectrum) const;
+
+	inline size_t GetSize() const { return size; }
+	inline size_t GetSpectrumSize() const { return size / 2 + 1; }
+
+	static std::shared_ptr<const RealFFTPlan> Get(const size_t size);
+
+private:
+	size_t size;
+	std::shared_ptr<const FFTPlan> halfPlan;
+	FTdata twiddles;
+};
@@ -0,0 +1,130 @@
+#include <algorithm>
+
+#include "GoertzelBank.h"
+#include "LruCache.h"
+#include "Simd.h"
+
+// Egy flhangnyi felbontshoz szksges Q tnyez (1 / (2^(1/12) - 1)), a Hann-ablak
+// ktbin szles fhurka miatt ktszeresen.
+static const double ResolutionQ = 2.0 / (1.0594630943592953 - 1.0);
+
+GoertzelBank::GoertzelBank(const unsigned sampleRate, const unsigned windowSize, const float referencePitch, const WindowType windowType)
+{
+	const std::pair<int, int> range = GetAnalysisNoteRange(referencePitch, sampleRate);
+	firstMidi = range.first;
+	const int lastMidi = range.second;
+	noteCount = lastMidi >= firstMidi ? static_cast<size_t>(lastMidi - firstMidi + 1) : 0;
+
+	const size_t groupCount = (noteCount + GroupSize - 1) / GroupSize;
+	coefficients.assign(groupCount * GroupSize, 0.0f);
+
+	for (size_t g = 0; g < groupCount; g++)
+	{
+		for (size_t k = g * GroupSize; k < std::min(noteCount, (g + 1) * GroupSize); k++)
+		{
+			const double f = MidiToFrequency(static_cast<float>(firstMidi + static_cast<int>(k)), referencePitch);
+			coefficients[k] = static_cast<float>(2.0 * std::cos(2.0 * 3.14159265358979323846 * f / sampleRate));
+		}
+
+		// A csoport legmlyebb hangja hatrozza meg a szksges szakaszhosszt.
+		const double lowest = MidiToFrequency(static_cast<float>(firstMidi + static_cast<int>(g * GroupSize)), referencePitch);
+		const size_t length = std::min<size_t>(windowSize, static_cast<size_t>(std::ceil(ResolutionQ * sampleRate / lowest)));
+
+		Group group;
+		group.Offset = (windowSize - length) / 2;
+		group.Length = length;
+		group.Window = std::make_shared<const std::vector<float>>(WindowFunction::Build(windowType, length));
+
+		double gain = 0.0;
+		for (const float w : *group.Window)
+			gain += w;
+		group.Gain = static_cast<float>(gain > 0.0 ? gain : 1.0);
+
+		groups.push_back(group);
+	}
+}
+
+// s[n] = x[n] + c * s[n-1] - s[n-2], GroupSize hang egyszerre
+static void GoertzelGroupScalar(const float* x, const float* w, const size_t length, const float* c, float* s1, float* s2)
+{
+	float a[GoertzelBank::GroupSize] = {};
+	float b[GoertzelBank::GroupSize] = {};
+
+	for (size_t n = 0; n < length; n++)
+	{
+		const float v = x[n] * w[n];
+		for (size_t k = 0; k < GoertzelBank::GroupSize; k++)
+		{
+			const float s0 = c[k] * a[k] + (v - b[k]);
+			b[k] = a[k];
+			a[k] = s0;
+		}
+	}
+
+	std::copy(a, a + GoertzelBank::GroupSize, s1);
+	std::copy(b, b + GoertzelBank::GroupSize, s2);
+}
+
+#if defined(TONELYZER_X86_SIMD)
+
+// AVX2 + FMA: 4 fggetlen regiszternyi (4 x 8) hang, hogy a rekurzi ksleltetse elrejthet legyen.
+// A (v - s[n-2]) kivons nincs a fggsgi lncon, gy mintnknt csak egy FMA ksleltetse szmt.
+TONELYZER_TARGET_AVX2
+static void GoertzelGroupAvx2(const float* x, const float* w, const size_t length, const float* c, float* s1, float* s2)
+{
+	const __m256 c0 = _mm256_loadu_ps(c), c1 = _mm256_loadu_ps(c + 8);
+	const __m256 c2 = _mm256_loadu_ps(c + 16), c3 = _mm256_loadu_ps(c + 24);
+	__m256 a0 = _mm256_setzero_ps(), a1 = a0, a2 = a0, a3 = a0;
+	__m256 b0 = a0, b1 = a0, b2 = a0, b3 = a0;
+
+	for (size_t n = 0; n < length; n++)
+	{
+		const __m256 v = _mm256_set1_ps(x[n] * w[n]);
+		__m256 t;
+		t = _mm256_fmadd_ps(c0, a0, _mm256_sub_ps(v, b0)); b0 = a0; a0 = t;
+		t = _mm256_fmadd_ps(c1, a1, _mm256_sub_ps(v, b1)); b1 = a1; a1 = t;
+		t = _mm256_fmadd_ps(c2, a2, _mm256_sub_ps(v, b2)); b2 = a2; a2 = t;
+		t = _mm256_fmadd_ps(c3, a3, _mm256_sub_ps(v, b3)); b3 = a3; a3 = t;
+	}
+
+	_mm256_storeu_ps(s1, a0); _mm256_storeu_ps(s1 + 8, a1); _mm256_storeu_ps(s1 + 16, a2); _mm256_storeu_ps(s1 + 24, a3);
+	_mm256_storeu_ps(s2, b0); _mm256_storeu_ps(s2 + 8, b1); _mm256_storeu_ps(s2 + 16, b2); _mm256_storeu_ps(s2 + 24, b3);
+}
+
+#endif
+
+void GoertzelBank::Process(const float* frame, FTdata& result) const
+{
+	result.resize(noteCount);
+
+	float s1[GroupSize], s2[GroupSize];
+	for (size_t g = 0; g < groups.size(); g++)
+	{
+		const Group& group = groups[g];
+		const float* c = coefficients.data() + g * GroupSize;
+
+#if defined(TONELYZER_X86_SIMD)
+		const CpuFeatures& cpu = GetCpuFeatures();
+		if (cpu.AVX2 && cpu.FMA)
+			GoertzelGroupAvx2(frame + group.Offset, group.Window->data(), group.Length, c, s1, s2);
+		else
+#endif
+			GoertzelGroupScalar(frame + group.Offset, group.Window->data(), group.Length, c, s1, s2);
+
+		// |X|^2 = s1^2 + s2^2 - c * s1 * s2, az ablak sszegvel normlva
+		for (size_t k = 0; k < GroupSize && g * GroupSize + k < noteCount; k++)
+		{
+			const float power = s1[k] * s1[k] + s2[k] * s2[k] - c[k] * s1[k] * s2[k];
+			result[g * GroupSize + k] = std::sqrt(std::max(power, 0.0f)) / group.Gain;
+		}
+	}
+}
+
+std::shared_ptr<const GoertzelBank> GoertzelBank::Get(const unsigned sampleRate, const unsigned windowSize, const float referencePitch, const WindowType windowType)
+{
+	static LruCache<std::tuple<unsigned, unsigned, float, WindowType>, GoertzelBank> cache(CacheCapacity);
+	return cache.Get(std::make_tuple(sampleRate, windowSize, referencePitch, windowType), [&]()
+	{
+		return std::make_shared<const GoertzelBank>(sampleRate, windowSize, referencePitch, windowType);
+	});
+}
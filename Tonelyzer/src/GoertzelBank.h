@@ -0,0 +1,46 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <tuple>
+
+#include "Structures.h"
+#include "WindowFunction.h"
+
+// Goertzel-szrbank: csak a MinAnalysisFrequency s MaxAnalysisFrequency kz es
+// hangkzppontok (flhangonknt egy frekvencia) amplitdit szmolja, teljes FFT nlkl.
+// A hangok GroupSize-os csoportokban, SIMD-del prhuzamosan futnak; egy csoport a legmlyebb
+// hangjhoz szksges (lland Q-j) hosszsg, az ablak kzepre illesztett szakaszt dolgozza fel,
+// gy a magas hangok csoportjai az ablaknak csak tredkt olvassk.
+class GoertzelBank
+{
+public:
+	static const size_t GroupSize = 32;
+
+	GoertzelBank(const unsigned sampleRate, const unsigned windowSize, const float referencePitch, const WindowType windowType);
+
+	// frame: windowSize darab (ablakozatlan) minta, result: hangonknt egy amplitd
+	void Process(const float* frame, FTdata& result) const;
+
+	inline int GetFirstMidi() const { return firstMidi; }
+	inline size_t GetNoteCount() const { return noteCount; }
+
+	// Konfigurcinknt megosztott pldny; a legutbb hasznlt CacheCapacity konfigurci marad meg.
+	static std::shared_ptr<const GoertzelBank> Get(const unsigned sampleRate, const unsigned windowSize, const float referencePitch, const WindowType windowType);
+
+private:
+	static const size_t CacheCapacity = 8;
+
+	struct Group
+	{
+		size_t Offset;
+		size_t Length;
+		float Gain;
+		std::shared_ptr<const std::vector<float>> Window;
+	};
+
+	int firstMidi;
+	size_t noteCount;
+	std::vector<float> coefficients; // 2*cos(omega) hangonknt, GroupSize tbbszrsre kiegsztve
+	std::vector<Group> groups;
+};
@@ -0,0 +1,124 @@
+#include "KeyProfiles.h"
+#include "Simd.h"
+
+#if defined(TONELYZER_X86_SIMD)
+
+// scores[r] = sum_i h[i] * columns[i * rows + r], ahol rows 8 tbbszrse
+static void MultiplySse2(const float* columns, const size_t rows, const float* h, float* scores)
+{
+	for (size_t r = 0; r < rows; r += 8)
+	{
+		__m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+		for (size_t i = 0; i < 12; i++)
+		{
+			const __m128 value = _mm_set1_ps(h[i]);
+			acc0 = _mm_add_ps(acc0, _mm_mul_ps(value, _mm_loadu_ps(columns + i * rows + r)));
+			acc1 = _mm_add_ps(acc1, _mm_mul_ps(value, _mm_loadu_ps(columns + i * rows + r + 4)));
+		}
+		_mm_storeu_ps(scores + r, acc0);
+		_mm_storeu_ps(scores + r + 4, acc1);
+	}
+}
+
+TONELYZER_TARGET_AVX2
+static void MultiplyAvx2(const float* columns, const size_t rows, const float* h, float* scores)
+{
+	for (size_t r = 0; r < rows; r += 8)
+	{
+		__m256 acc = _mm256_setzero_ps();
+		for (size_t i = 0; i < 12; i++)
+			acc = _mm256_fmadd_ps(_mm256_set1_ps(h[i]), _mm256_loadu_ps(columns + i * rows + r), acc);
+		_mm256_storeu_ps(scores + r, acc);
+	}
+}
+
+#endif
+
+static void Multiply(const float* columns, const size_t rows, const float* h, float* scores)
+{
+#if defined(TONELYZER_X86_SIMD)
+	const CpuFeatures& cpu = GetCpuFeatures();
+	if (cpu.AVX2 && cpu.FMA)
+		MultiplyAvx2(columns, rows, h, scores);
+	else
+		MultiplySse2(columns, rows, h, scores);
+#else
+	for (size_t r = 0; r < rows; r++)
+	{
+		float sum = 0.0f;
+		for (size_t i = 0; i < 12; i++)
+			sum += h[i] * columns[i * rows + r];
+		scores[r] = sum;
+	}
+#endif
+}
+
+// A hisztogram centrlsa s normlsa; a profilok mr centrltak s normltak,
+// gy a korrelci a kt vektor skalrszorzata.
+static void Normalize(const PitchHistogram& histogram, float* h)
+{
+	float mean = 0.0f;
+	for (const float value : histogram)
+		mean += value;
+	mean /= 12.0f;
+
+	float norm = 0.0f;
+	for (int i = 0; i < 12; i++)
+	{
+		h[i] = histogram[i] - mean;
+		norm += h[i] * h[i];
+	}
+
+	// Konstans hisztogramnl a korrelci nem rtelmezett: minden pontszm 0 lesz.
+	const float scale = norm > 0.0f ? 1.0f / std::sqrt(norm) : 0.0f;
+	for (int i = 0; i < 12; i++)
+		h[i] *= scale;
+}
+
+void KeyProfiles::Score(const KeyProfileMatrix& matrix, const PitchHistogram& histogram, KeyScores& scores)
+{
+	float h[12];
+	Normalize(histogram, h);
+	Multiply(&matrix.Columns[0][0], 24, h, scores.data());
+}
+
+KeyPair KeyProfiles::GetBestKey(const KeyScores& scores, float* bestScore)
+{
+	return GetBestKey(scores.data(), bestScore);
+}
+
+KeyPair KeyProfiles::GetBestKey(const float* scores, float* bestScore)
+{
+	int best = 0;
+	for (int r = 1; r < 24; r++)
+		if (scores[best] < scores[r])
+			best = r;
+
+	if (bestScore)
+		*bestScore = scores[best];
+	return KeyPair(best % 12, best < 12 ? 1 : 0);
+}
+
+void KeyProfileBank::Add(const KeyProfileMatrix& matrix)
+{
+	// Oszlopfolytonos trendezs: minden hangosztly-oszlop vgre kerl az j csald 24 sora.
+	const size_t oldRows = rows;
+	rows += 24;
+
+	std::vector<float> merged(12 * rows);
+	for (size_t i = 0; i < 12; i++)
+	{
+		std::copy(columns.begin() + i * oldRows, columns.begin() + (i + 1) * oldRows, merged.begin() + i * rows);
+		std::copy(matrix.Columns[i], matrix.Columns[i] + 24, merged.begin() + i * rows + oldRows);
+	}
+	columns = std::move(merged);
+}
+
+void KeyProfileBank::Score(const PitchHistogram& histogram, std::vector<float>& scores) const
+{
+	float h[12];
+	Normalize(histogram, h);
+	scores.resize(rows);
+	if (rows > 0)
+		Multiply(columns.data(), rows, h, scores.data());
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Structures.h"
+
+// A 24 hangnem (12 dr, majd 12 moll) korrelcis pontszmai
+using KeyScores = std::array<float, 24>;
+
+// A 24 elforgatott hangnemprofil tlagra centrlva s egysgnyi normra sklzva, oszlopfolytonosan:
+// Columns[i][r] az r. hangnem (r < 12: dr, r >= 12: moll, alaphang r % 12) i. hangosztlynak slya.
+// gy a Pearson-korrelci egy centrlt, normlt hisztogram s a mtrix szorzata, ahol a 24 pontszm
+// egyszerre, 24 elem oszlopvektorok slyozott sszegeknt szmoldik.
+struct KeyProfileMatrix
+{
+	alignas(32) float Columns[12][24];
+};
+
+class KeyProfiles
+{
+public:
+	// Fordtsi idben kirtkelhet mtrixpts egy dr s egy moll (C alaphang) profilbl
+	static constexpr KeyProfileMatrix BuildMatrix(const PitchHistogram& major, const PitchHistogram& minor)
+	{
+		KeyProfileMatrix matrix{};
+		for (int scale = 0; scale < 2; scale++)
+		{
+			const PitchHistogram& profile = scale == 0 ? major : minor;
+
+			double mean = 0.0;
+			for (int i = 0; i < 12; i++)
+				mean += profile[i];
+			mean /= 12.0;
+
+			double norm = 0.0;
+			for (int i = 0; i < 12; i++)
+				norm += (profile[i] - mean) * (profile[i] - mean);
+			norm = Sqrt(norm);
+
+			// Az r alaphang hangnem i. eleme a C alaphang profil (i - r) mod 12. eleme.
+			for (int root = 0; root < 12; root++)
+				for (int i = 0; i < 12; i++)
+					matrix.Columns[i][scale * 12 + root] = static_cast<float>((profile[(i + 12 - root) % 12] - mean) / norm);
+		}
+		return matrix;
+	}
+
+	// Mind a 24 hangnem Pearson-korrelcija a hisztogrammal
+	static void Score(const KeyProfileMatrix& matrix, const PitchHistogram& histogram, KeyScores& scores);
+
+	// A legjobb hangnem (alaphang, 1: dr / 0: moll); egyezsnl a dr s az alacsonyabb alaphang nyer.
+	static KeyPair GetBestKey(const KeyScores& scores, float* bestScore = nullptr);
+	static KeyPair GetBestKey(const float* scores, float* bestScore = nullptr);
+
+private:
+	// Newton-iterci, mert az std::sqrt nem constexpr
+	static constexpr double Sqrt(const double x)
+	{
+		double root = x > 1.0 ? x : 1.0;
+		for (int i = 0; i < 64; i++)
+			root = 0.5 * (root + x / root);
+		return root;
+	}
+};
+
+// Tbb profilcsald (csaldonknt 24 hangnem) egyetlen mtrixban: egy hisztogram sszes csaldra
+// vonatkoz korrelcija egyetlen mtrix-vektor szorzssal addik. A c. csald pontszmai a
+// [24 * c, 24 * c + 24) tartomnyban vannak.
+class KeyProfileBank
+{
+public:
+	void Add(const KeyProfileMatrix& matrix);
+	void Score(const PitchHistogram& histogram, std::vector<float>& scores) const;
+
+	inline size_t GetFamilyCount() const { return rows / 24; }
+
+private:
+	size_t rows = 0;
+	std::vector<float> columns; // [12][rows]
+};
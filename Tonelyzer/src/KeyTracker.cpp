@@ -0,0 +1,113 @@
+#include <cstdio>
+
+#include "KeyTracker.h"
+
+KeyTracker::KeyTracker(const PitchAnalyzer& analyzer, const double spanSeconds, const double hopSeconds)
+	: analyzer(analyzer), hopSeconds(hopSeconds)
+{
+	const size_t span = static_cast<size_t>(std::llround(spanSeconds / hopSeconds));
+	ring.resize(std::max<size_t>(span, 1));
+	Reset();
+}
+
+void KeyTracker::Reset()
+{
+	head = 0;
+	count = 0;
+	sum.fill(0.0);
+}
+
+void KeyTracker::Push(const ChromaFrame& frame)
+{
+	// Msfl lpsnl nagyobb ugrs: j idszakasz, a korbbi ablakok nem tartoznak hozz.
+	if (count > 0 && (frame.Time - lastTime > 1.5 * hopSeconds || frame.Time < lastTime))
+		Reset();
+
+	PitchHistogram& slot = ring[head];
+	if (count == ring.size())
+	{
+		for (size_t i = 0; i < 12; i++)
+			sum[i] -= slot[i];
+	}
+	else
+		count++;
+
+	slot = frame.Chroma;
+	for (size_t i = 0; i < 12; i++)
+		sum[i] += slot[i];
+
+	head = (head + 1) % ring.size();
+	lastTime = frame.Time;
+	firstTime = frame.Time - (count - 1) * hopSeconds;
+
+	PitchHistogram histogram;
+	for (size_t i = 0; i < 12; i++)
+		histogram[i] = static_cast<float>(std::max(sum[i], 0.0));
+
+	// Az ablakok fl ablakmretenknt (hop) kvetik egymst, gy egy ablak kzepe a kezdete utn egy lpssel van.
+	KeyFrame result;
+	result.Time = (firstTime + lastTime) / 2.0 + hopSeconds;
+	result.Estimate = analyzer.CalculateKeys(histogram).Ensemble;
+	frames.push_back(result);
+}
+
+std::vector<KeyRegion> KeyTracker::GetRegions() const
+{
+	std::vector<KeyRegion> regions;
+	size_t members = 0;
+	double previousTime = 0.0;
+	for (const KeyFrame& frame : frames)
+	{
+		// Egy szakaszon bell a becslsek legfeljebb egy lpsnyire kvetik egymst; nagyobb ugrs
+		// idszakasz-hatrt jelent, ott a hangnemtl fggetlenl j szakasz kezddik.
+		const bool gap = !regions.empty() && frame.Time - previousTime > 1.5 * hopSeconds;
+		if (regions.empty() || gap || regions.back().Key != frame.Estimate.Key)
+		{
+			if (!regions.empty())
+			{
+				regions.back().End = gap ? previousTime + hopSeconds : frame.Time;
+				regions.back().Score /= members;
+			}
+
+			// Egy folytonos rsz els becslse egyetlen ablakra vonatkozik, ennek kezdete egy lpssel korbbi.
+			KeyRegion region;
+			region.Start = regions.empty() || gap ? frame.Time - hopSeconds : frame.Time;
+			region.Key = frame.Estimate.Key;
+			regions.push_back(region);
+			members = 0;
+		}
+
+		regions.back().Score += frame.Estimate.Score;
+		members++;
+		previousTime = frame.Time;
+	}
+
+	if (!regions.empty())
+	{
+		regions.back().End = lastTime + 2.0 * hopSeconds; // az utols ablak vge
+		regions.back().Score /= members;
+	}
+
+	return regions;
+}
+
+std::string KeyTracker::FormatTime(const double seconds)
+{
+	const double clamped = std::max(seconds, 0.0);
+	const int minutes = static_cast<int>(clamped / 60.0);
+	char text[32];
+	std::snprintf(text, sizeof(text), "%d:%04.1f", minutes, clamped - minutes * 60.0);
+	return text;
+}
+
+void KeyTracker::Print() const
+{
+	std::cout << "Key track (" << ring.size() * hopSeconds << "s span, " << hopSeconds << "s hop):" << std::endl;
+	for (const KeyFrame& frame : frames)
+		std::cout << "  " << FormatTime(frame.Time) << "  " << PitchAnalyzer::GetKeyName(frame.Estimate.Key) << " (r = " << frame.Estimate.Score << ")" << std::endl;
+
+	std::cout << "Key regions:" << std::endl;
+	for (const KeyRegion& region : GetRegions())
+		std::cout << "  " << FormatTime(region.Start) << " - " << FormatTime(region.End) << "  " << PitchAnalyzer::GetKeyName(region.Key) << " (r = " << region.Score << ")" << std::endl;
+	std::cout << "--------------------------------" << std::endl;
+}
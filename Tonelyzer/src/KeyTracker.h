@@ -0,0 +1,43 @@
+#pragma once
+
+#include "PitchAnalyzer.h"
+
+// Idbeli hangnemkvets cssz ablakkal. Az ablakok hangosztly-vektorai egy span elem
+// gyrpufferbe kerlnek, a fut sszeghez az j vektor hozzaddik, a kies levondik, gy
+// lpsenknt (hop) a hisztogram frisstse 12 sszeads s 12 kivons; ezutn a kivlasztott
+// profilcsaldok egyetlen mtrix-vektor szorzattal pontozzk az aktulis ablakot.
+// Az idben nem folytonos ablakok (idszakaszok hatra) a cssz ablakot kirtik.
+class KeyTracker
+{
+public:
+	// spanSeconds: a cssz ablak hossza, hopSeconds: kt egymst kvet ablak tvolsga
+	KeyTracker(const PitchAnalyzer& analyzer, const double spanSeconds, const double hopSeconds);
+
+	void Push(const ChromaFrame& frame);
+	void Reset();
+
+	inline const std::vector<KeyFrame>& GetFrames() const { return frames; }
+	inline size_t GetSpanFrames() const { return ring.size(); }
+
+	// Az azonos hangnem egymst kvet becslsek sszevonsa
+	std::vector<KeyRegion> GetRegions() const;
+
+	void Print() const;
+
+	// "perc:msodperc.tized" alak
+	static std::string FormatTime(const double seconds);
+
+private:
+
+	const PitchAnalyzer& analyzer;
+	double hopSeconds;
+
+	std::vector<PitchHistogram> ring;
+	size_t head = 0;  // a kvetkez bers helye (egyben a legrgebbi elem, ha a puffer tele van)
+	size_t count = 0;
+	std::array<double, 12> sum; // dupla pontossg fut sszeg, hogy az sszeads/kivons ne halmozzon hibt
+	double firstTime = 0.0; // a cssz ablakban lv legrgebbi ablak kezdete
+	double lastTime = 0.0;
+
+	std::vector<KeyFrame> frames;
+};
@@ -0,0 +1,283 @@
+#include <cstring>
+#include <limits>
+
+#include "LiveAnalyzer.h"
+#include "KeyTracker.h"
+
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+static size_t GetSampleBytes(const PcmFormat format)
+{
+	return format == PcmFormat::S16 ? 2 : 4;
+}
+
+static const char* GetFormatName(const PcmFormat format)
+{
+	switch (format)
+	{
+	case PcmFormat::S32: return "s32";
+	case PcmFormat::F32: return "f32";
+	default: return "s16";
+	}
+}
+
+const size_t LiveAnalyzer::LatencyStats::BucketCount;
+
+void LiveAnalyzer::LatencyStats::Add(const double milliseconds)
+{
+	Buckets[std::min(static_cast<size_t>(milliseconds * 100.0), BucketCount)]++;
+	Count++;
+	Sum += milliseconds;
+	Max = std::max(Max, milliseconds);
+}
+
+// A rekesz fels hatra, amely alatt a mrsek legalbb fraction rsze van
+double LiveAnalyzer::LatencyStats::GetPercentile(const double fraction) const
+{
+	const size_t target = static_cast<size_t>(std::ceil(fraction * Count));
+	size_t seen = 0;
+	for (size_t i = 0; i < Buckets.size(); i++)
+	{
+		seen += Buckets[i];
+		if (seen >= target && seen > 0)
+			return i < BucketCount ? std::min((i + 1) / 100.0, Max) : Max;
+	}
+	return 0.0;
+}
+
+LiveAnalyzer::LiveAnalyzer(const InitData& init)
+	: init(init), settings(init.Live), analyzer(empty), downmixer(std::max(init.Live.Channels, 1u), init.Input.Downmix), mode(init.FourierMode)
+{
+	analyzer.SetProfiles(init.Profiles);
+
+	// Alulmintavtelezsnl az ablakmret a ritkts arnyban cskken (lsd main).
+	analysisRate = settings.SampleRate;
+	windowSize = init.FTWindowSize;
+	if (init.Input.Decimate && settings.SampleRate > 0)
+	{
+		decimator.reset(new Decimator(settings.SampleRate));
+		analysisRate = decimator->GetOutputSampleRate();
+		windowSize = std::max(128u, windowSize / decimator->GetFactor());
+	}
+	hop = windowSize / 2;
+
+	if (mode == FTmode::DFT)
+	{
+		std::cerr << "DFT mode is too slow for live input, using FFT." << std::endl;
+		mode = FTmode::FFT;
+	}
+	if (init.EstimateTuning)
+		std::cerr << "Tuning estimation is not available for live input, using " << init.ReferencePitch << " Hz." << std::endl;
+}
+
+void LiveAnalyzer::Convert(const unsigned char* raw, const size_t frames, float* interleaved) const
+{
+	const size_t count = frames * settings.Channels;
+	if (settings.Format == PcmFormat::F32)
+		std::memcpy(interleaved, raw, count * sizeof(float));
+	else if (settings.Format == PcmFormat::S32)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			int32_t sample;
+			std::memcpy(&sample, raw + i * 4, 4);
+			interleaved[i] = sample * (1.0f / 2147483648.0f);
+		}
+	}
+	else
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			int16_t sample;
+			std::memcpy(&sample, raw + i * 2, 2);
+			interleaved[i] = sample * (1.0f / 32768.0f);
+		}
+	}
+}
+
+// Az aktulis ablak hangosztly-vektora, a Transformer ablakonknti tjval azonosan
+void LiveAnalyzer::ProcessWindow(PitchHistogram& chroma)
+{
+	chroma.fill(0.0f);
+	if (mode == FTmode::GOERTZEL)
+	{
+		bank->Process(window.data(), result);
+		ChromaMap::FoldNotes(result, bank->GetFirstMidi(), 1, chroma);
+	}
+	else if (mode == FTmode::CQT)
+	{
+		// A svkeretek a jelpiramisbl jnnek, a keret kzepe az ablak. A mly svok csak minden Stride.
+		// lpsben futnak, kzben a legutbbi eredmnyk marad (az els kirtkelt lpsben minden sv fut).
+		const size_t position = hops - warmupHops;
+		const size_t center = hops * hop - window.size() / 2;
+		for (size_t b = 0; b < cqt->GetBandCount(); b++)
+		{
+			const CQTKernel::Band& band = cqt->GetBand(b);
+			if (position % band.Stride != 0)
+				continue;
+			band.Plan->Forward(pyramid->GetSamples(band.Level, (center >> band.Level) - band.FrameSize / 2), nullptr, spectrum);
+			cqt->Apply(b, spectrum, result);
+		}
+		ChromaMap::FoldNotes(result, cqt->GetFirstMidi(), cqt->GetBinsPerSemitone(), chroma);
+	}
+	else
+	{
+		realPlan->Forward(window.data(), weights->data(), result);
+		chromaMap->Fold(result, chroma);
+	}
+}
+
+int LiveAnalyzer::Run(std::FILE* input)
+{
+	if (settings.SampleRate == 0 || settings.Channels == 0)
+	{
+		std::cerr << "Live input needs a sample rate (-rate) and a channel count (-channels)." << std::endl;
+		return 1;
+	}
+
+	if (windowSize < 128 || windowSize > 32768 || (windowSize & (windowSize - 1)) != 0)
+	{
+		std::cerr << "DFT / FFT window size must be a power of two between 128 and 32768!" << std::endl;
+		return 1;
+	}
+
+#if defined(_WIN32)
+	_setmode(_fileno(input), _O_BINARY); // a szabvnyos bemenet alaprtelmezetten szveges md
+#endif
+	// Pufferels nlkl az fread kzvetlenl a rendszerhvsbl tr vissza, gy a berkezs ideje a
+	// lps utols mintj, nem egy korbban, elre beolvasott puffer.
+	std::setvbuf(input, nullptr, _IONBF, 0);
+
+	// A tblk s tervek elre elkszlnek, hogy az els lps se vrjon rjuk.
+	realPlan = RealFFTPlan::Get(windowSize);
+	weights = WindowFunction::Get(init.Window, windowSize);
+	if (mode == FTmode::GOERTZEL)
+	{
+		bank = GoertzelBank::Get(analysisRate, windowSize, init.ReferencePitch, init.Window);
+		result.resize(bank->GetNoteCount());
+	}
+	else if (mode == FTmode::CQT)
+	{
+		cqt = CQTKernel::Get(analysisRate, windowSize, init.ReferencePitch, init.BinsPerSemitone, init.Window);
+		pyramid.reset(new OctavePyramid(cqt->GetLevelCount()));
+		result.resize(cqt->GetBinCount());
+	}
+	else
+	{
+		chromaMap = ChromaMap::Get(analysisRate, windowSize, init.ReferencePitch);
+		result.resize(windowSize / 2 + 1);
+	}
+	window.assign(cqt ? cqt->GetFrameSize() : windowSize, 0.0f);
+
+	// Az ablak els feltltdsig a kezdeti nullk torztank a becslst, ezrt addig nincs kirs,
+	// s a hisztogram sem kap hozzjrulst.
+	warmupHops = window.size() / hop;
+	const double hopSeconds = static_cast<double>(hop) / analysisRate;
+	const double decay = settings.Decay > 0.0 ? std::exp(-hopSeconds / settings.Decay) : 1.0;
+
+	std::cout << "Tonelyzer: Live " << GetFormatName(settings.Format) << " input, " << settings.SampleRate << " Hz, " << settings.Channels << " channel(s), ";
+	std::cout << GetFTmodeName(mode) << " mode with " << WindowFunction::GetName(init.Window) << " window of " << windowSize << " samples";
+	std::cout << " (hop " << hopSeconds * 1000.0 << " ms, decay " << settings.Decay << " s, first estimate after " << warmupHops * hopSeconds * 1000.0 << " ms)" << std::endl;
+	std::cout << "--------------------------------" << std::endl;
+
+	// Egy olvass pontosan egy lpsnyi kpkockt kr: az fread csbl addig vr, amg ennyi be nem rkezik.
+	const size_t frameBytes = GetSampleBytes(settings.Format) * settings.Channels;
+	const size_t readFrames = hop * (decimator ? decimator->GetFactor() : 1);
+	std::vector<unsigned char> raw(readFrames * frameBytes);
+	std::vector<float> interleaved(readFrames * settings.Channels);
+	std::vector<float> mono(readFrames);
+	std::vector<float> pending; // a mg ablakba nem kerlt (ritktott) mon mintk
+
+	std::array<double, 12> histogram;
+	histogram.fill(0.0);
+	PitchHistogram chroma;
+
+	while (true)
+	{
+		const size_t frames = std::fread(raw.data(), frameBytes, readFrames, input);
+		const Clock::time_point arrival = Clock::now();
+		if (frames == 0)
+			break;
+
+		Convert(raw.data(), frames, interleaved.data());
+		downmixer.Process(interleaved.data(), frames, mono.data());
+		if (decimator)
+			decimator->Process(mono.data(), frames, pending);
+		else
+			pending.insert(pending.end(), mono.begin(), mono.begin() + frames);
+
+		size_t consumed = 0;
+		while (pending.size() - consumed >= hop)
+		{
+			const Clock::time_point start = Clock::now();
+
+			// Az ablak egy lpssel elrbb csszik: a msodik fele az elejre, az j lps a vgre kerl.
+			std::copy(window.begin() + hop, window.end(), window.begin());
+			std::copy(pending.begin() + consumed, pending.begin() + consumed + hop, window.end() - hop);
+			if (pyramid)
+			{
+				DiscardPyramid();
+				pyramid->Append(pending.data() + consumed, hop);
+			}
+			consumed += hop;
+			hops++;
+			if (hops < warmupHops)
+				continue;
+
+			ProcessWindow(chroma);
+			PitchHistogram decayed;
+			for (size_t i = 0; i < 12; i++)
+			{
+				histogram[i] = decay * histogram[i] + chroma[i];
+				decayed[i] = static_cast<float>(histogram[i]);
+			}
+			const KeyEstimate estimate = analyzer.CalculateKeys(decayed).Ensemble;
+			const Clock::time_point computed = Clock::now();
+
+			const double delay = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - arrival).count() / 1000.0;
+			std::cout << "  " << KeyTracker::FormatTime(hops * hopSeconds) << "  " << PitchAnalyzer::GetKeyName(estimate.Key) << " (r = " << estimate.Score << ")  " << delay << " ms" << std::endl;
+
+			processing.Add(std::chrono::duration_cast<std::chrono::microseconds>(computed - start).count() / 1000.0);
+			latency.Add(delay);
+		}
+		pending.erase(pending.begin(), pending.begin() + consumed);
+	}
+
+	PrintSummary();
+	return 0;
+}
+
+// A piramisbl a kvetkez lps svkereteinl korbbi mintk eldobsa (a lps minti eltt)
+void LiveAnalyzer::DiscardPyramid()
+{
+	const size_t end = (hops + 1) * hop;
+	if (end < window.size())
+		return; // az ablak els feltltdsig nem kszl becsls
+
+	const size_t center = end - window.size() / 2;
+	for (size_t level = 0; level < pyramid->GetLevelCount(); level++)
+	{
+		size_t first = std::numeric_limits<size_t>::max();
+		for (size_t b = 0; b < cqt->GetBandCount(); b++)
+			if (cqt->GetBand(b).Level == level)
+				first = std::min(first, (center >> level) - cqt->GetBand(b).FrameSize / 2);
+		pyramid->Discard(level, first);
+	}
+}
+
+void LiveAnalyzer::PrintSummary() const
+{
+	const double hopMilliseconds = 1000.0 * hop / analysisRate;
+	std::cout << "--------------------------------" << std::endl;
+	std::cout << hops << " hops of " << hopMilliseconds << " ms, window " << 1000.0 * windowSize / analysisRate << " ms, " << latency.Count << " estimates" << std::endl;
+	if (latency.Count == 0)
+		return;
+
+	std::cout << "Processing per hop: mean " << processing.Sum / processing.Count << " ms, p99 " << processing.GetPercentile(0.99)
+		<< " ms, max " << processing.Max << " ms (" << 100.0 * processing.Sum / processing.Count / hopMilliseconds << "% of real time)" << std::endl;
+	std::cout << "Latency after the last sample of a hop: mean " << latency.Sum / latency.Count << " ms, p99 " << latency.GetPercentile(0.99)
+		<< " ms, max " << latency.Max << " ms" << std::endl;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdio>
+#include <memory>
+
+#include "PitchAnalyzer.h"
+#include "Downmixer.h"
+#include "Decimator.h"
+#include "ChromaMap.h"
+
+// l bemenet (pl. DJ- vagy adsfolyam) vals idej hangnembecslse (-live). A nyers, tlapolt
+// PCM jel lpsenknt (hop, fl ablak) rkezik; minden teljes lps utn az utols ablak
+// transzformldik, hangosztly-vektora egy exponencilisan felejt hisztogramhoz addik
+// (h = d * h + c, d = exp(-hop / decay)), s a becslt hangnem azonnal kirdik. A becsls gy
+// a lps utols mintjnak berkezse utn egyetlen ablak feldolgozsi idejn bell megjelenik;
+// ezt a ksleltetst soronknt s a bemenet vgn sszestve is kirja. Szndkosan egyszl:
+// egy ablak szmtsa egy magon is a lps idejnek tredke, a szlkszlet csak ksleltetst adna.
+class LiveAnalyzer
+{
+public:
+	explicit LiveAnalyzer(const InitData& init);
+
+	LiveAnalyzer(const LiveAnalyzer&) = delete;
+	LiveAnalyzer& operator=(const LiveAnalyzer&) = delete;
+
+	// A bemenet vgig fut; 0 siker, 1 hiba esetn.
+	int Run(std::FILE* input);
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	// Ksleltetsek hisztogramja 10 s-os rekeszekben (a hossz folyamoknl sem n a memriaigny)
+	struct LatencyStats
+	{
+		static const size_t BucketCount = 10000; // 0 - 100 ms
+		std::vector<size_t> Buckets = std::vector<size_t>(BucketCount + 1, 0);
+		size_t Count = 0;
+		double Sum = 0.0;
+		double Max = 0.0;
+
+		void Add(const double milliseconds);
+		double GetPercentile(const double fraction) const;
+	};
+
+	void Convert(const unsigned char* raw, const size_t frames, float* interleaved) const;
+	void ProcessWindow(PitchHistogram& chroma);
+	void DiscardPyramid();
+	void PrintSummary() const;
+
+	InitData init;
+	LiveSettings settings;
+	Spectrum empty; // a PitchAnalyzer csak a profilpontozshoz kell, spektrum nlkl
+	PitchAnalyzer analyzer;
+	Downmixer downmixer;
+	std::unique_ptr<Decimator> decimator;
+
+	FTmode mode;
+	unsigned analysisRate;
+	unsigned windowSize;
+	size_t hop;
+	std::shared_ptr<const RealFFTPlan> realPlan;
+	std::shared_ptr<const std::vector<float>> weights;
+	std::shared_ptr<const ChromaMap> chromaMap;
+	std::shared_ptr<const GoertzelBank> bank;
+	std::shared_ptr<const CQTKernel> cqt;
+	std::unique_ptr<OctavePyramid> pyramid; // CQT mdban az oktvonknt ritktott jel
+
+	std::vector<float> window; // az utols windowSize (CQT mdban CQTKernel::GetFrameSize()) mon minta
+	FTdata spectrum;
+	FTdata result;
+
+	size_t hops = 0;
+	size_t warmupHops = 0; // az els becsls eltti lpsek (az ablak feltltdse)
+	LatencyStats latency;    // a lps utols mintjnak beolvasstl a becsls kirsig
+	LatencyStats processing; // transzformci, hisztogram s pontozs
+};
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+// Szlbiztos, legfeljebb capacity elem gyorsttr a legrgebben hasznlt elem kiszortsval.
+// A hosszan fut kiszolglban a referencia-hangmagassg (float) kulcs tblk gy nem nnek
+// korltlanul; a kiszortott elemet a mg fut elemzsek a shared_ptr rvn tovbb hasznlhatjk.
+// Az elemek a zron kvl plnek: a zr alatt csak egy shared_future helyfoglal kerl a listba, gy
+// egy lass pts nem tartja fel a tbbi kulcs lekrdezst, az azonos kulcsot krk pedig
+// az els pts eredmnyre vrnak.
+template <typename Key, typename Value>
+class LruCache
+{
+public:
+	explicit LruCache(const size_t capacity)
+		: capacity(capacity) {}
+
+	LruCache(const LruCache&) = delete;
+	LruCache& operator=(const LruCache&) = delete;
+
+	// A kulcshoz tartoz elem, vagy ha nincs, a create() eredmnye (egy kulcs egyszerre csak egyszer
+	// pl fel). Ha a create() kivtelt dob, a helyfoglal trldik, a kivtelt a vrakozk is megkapjk.
+	template <typename Factory>
+	std::shared_ptr<const Value> Get(const Key& key, Factory create)
+	{
+		std::promise<std::shared_ptr<const Value>> promise;
+		Result pending;
+		uint64_t serial = 0;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			const auto found = index.find(key);
+			if (found != index.end())
+			{
+				entries.splice(entries.begin(), entries, found->second);
+				pending = found->second->Pending;
+			}
+			else
+			{
+				serial = ++lastSerial;
+				entries.push_front(Entry{ key, promise.get_future().share(), serial });
+				index[key] = entries.begin();
+				if (entries.size() > capacity)
+				{
+					index.erase(entries.back().Id);
+					entries.pop_back();
+				}
+			}
+		}
+
+		// Ksz vagy ms szl pti: a zron kvl vrunk r.
+		if (serial == 0)
+			return pending.get();
+
+		try {
+			std::shared_ptr<const Value> value = create();
+			promise.set_value(value);
+			return value;
+		}
+		catch (...)
+		{
+			promise.set_exception(std::current_exception());
+			std::lock_guard<std::mutex> lock(mutex);
+			const auto found = index.find(key);
+			if (found != index.end() && found->second->Serial == serial) // kzben nem szorult ki s nem plt jra
+			{
+				entries.erase(found->second);
+				index.erase(found);
+			}
+			throw;
+		}
+	}
+
+private:
+	using Result = std::shared_future<std::shared_ptr<const Value>>;
+
+	struct Entry
+	{
+		Key Id;
+		Result Pending;
+		uint64_t Serial; // az pts azonostja, a sikertelen pts csak a sajt helyfoglaljt trli
+	};
+
+	size_t capacity;
+	std::list<Entry> entries; // ell a legutbb hasznlt
+	std::map<Key, typename std::list<Entry>::iterator> index;
+	uint64_t lastSerial = 0;
+	std::mutex mutex;
+};
@@ -0,0 +1,293 @@
+#include <cstdint>
+#include <cstring>
+
+#include "MappedWavReader.h"
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const unsigned WaveFormatPcm = 0x0001;
+static const unsigned WaveFormatFloat = 0x0003;
+static const unsigned WaveFormatExtensible = 0xFFFE;
+
+static unsigned ReadLE16(const unsigned char* p) { return p[0] | (p[1] << 8); }
+static unsigned ReadLE32(const unsigned char* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<unsigned>(p[3]) << 24); }
+
+std::unique_ptr<MappedWavReader> MappedWavReader::Open(const std::string& path, const InputSettings& settings)
+{
+	std::unique_ptr<MappedWavReader> reader(new MappedWavReader());
+	reader->filename = path;
+	if (!reader->Map(path) || !reader->ParseHeader())
+		return nullptr;
+
+	reader->downmixer.reset(new Downmixer(reader->channels, settings.Downmix));
+	reader->interleaved.resize(ConvertFrames * reader->channels);
+	reader->segments = GetSegments(settings.Ranges, reader->sampleRate, reader->totalFrames);
+	reader->length = GetSegmentsLength(reader->segments, reader->totalFrames);
+
+	if (settings.Decimate)
+	{
+		reader->decimator.reset(new Decimator(reader->sampleRate));
+		reader->decimationFactor = reader->decimator->GetFactor();
+		reader->sampleRate = reader->decimator->GetOutputSampleRate();
+		reader->length /= reader->decimationFactor;
+		reader->block.resize(BlockFrames);
+	}
+
+	reader->StartSegment();
+	return reader;
+}
+
+MappedWavReader::~MappedWavReader()
+{
+#if defined(_WIN32)
+	if (mapping)
+		UnmapViewOfFile(mapping);
+	if (mappingHandle)
+		CloseHandle(mappingHandle);
+	if (fileHandle && fileHandle != INVALID_HANDLE_VALUE)
+		CloseHandle(fileHandle);
+#else
+	if (mapping)
+		munmap(const_cast<unsigned char*>(mapping), mappingSize);
+#endif
+}
+
+bool MappedWavReader::Map(const std::string& path)
+{
+#if defined(_WIN32)
+	fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (fileHandle == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(fileHandle, &size) || size.QuadPart == 0)
+		return false;
+	mappingSize = static_cast<size_t>(size.QuadPart);
+
+	mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mappingHandle)
+		return false;
+
+	mapping = static_cast<const unsigned char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+	return mapping != nullptr;
+#else
+	const int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size <= 0)
+	{
+		close(fd);
+		return false;
+	}
+	mappingSize = static_cast<size_t>(info.st_size);
+
+	// A lekpezs a ler bezrsa utn is rvnyes marad.
+	void* address = mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (address == MAP_FAILED)
+		return false;
+
+	// Sorban olvassuk vgig: a kernel elre beolvashat, s a feldolgozott lapokat eldobhatja.
+	madvise(address, mappingSize, MADV_SEQUENTIAL);
+	mapping = static_cast<const unsigned char*>(address);
+	return true;
+#endif
+}
+
+bool MappedWavReader::ParseHeader()
+{
+	if (mappingSize < 12 || std::memcmp(mapping, "RIFF", 4) != 0 || std::memcmp(mapping + 8, "WAVE", 4) != 0)
+		return false;
+
+	bool hasFormat = false;
+	unsigned bits = 0;
+	size_t offset = 12;
+	while (offset + 8 <= mappingSize)
+	{
+		const unsigned char* chunk = mapping + offset;
+		const size_t chunkSize = ReadLE32(chunk + 4);
+		const unsigned char* body = chunk + 8;
+
+		if (std::memcmp(chunk, "fmt ", 4) == 0 && chunkSize >= 16 && offset + 8 + chunkSize <= mappingSize)
+		{
+			unsigned tag = ReadLE16(body);
+			channels = ReadLE16(body + 2);
+			sampleRate = ReadLE32(body + 4);
+			bits = ReadLE16(body + 14);
+
+			// WAVE_FORMAT_EXTENSIBLE: a tnyleges formtum az alformtum GUID els kt bjtja.
+			if (tag == WaveFormatExtensible)
+			{
+				if (chunkSize < 40)
+					return false;
+				tag = ReadLE16(body + 24);
+			}
+
+			if (tag == WaveFormatPcm && bits == 8)        format = SampleFormat::U8;
+			else if (tag == WaveFormatPcm && bits == 16)  format = SampleFormat::S16;
+			else if (tag == WaveFormatPcm && bits == 24)  format = SampleFormat::S24;
+			else if (tag == WaveFormatPcm && bits == 32)  format = SampleFormat::S32;
+			else if (tag == WaveFormatFloat && bits == 32) format = SampleFormat::F32;
+			else if (tag == WaveFormatFloat && bits == 64) format = SampleFormat::F64;
+			else
+				return false;
+
+			hasFormat = channels > 0 && sampleRate > 0;
+		}
+		else if (std::memcmp(chunk, "data", 4) == 0)
+		{
+			if (!hasFormat)
+				return false;
+
+			// Csonka fjlnl a tnylegesen meglv adatot hasznljuk.
+			bytesPerFrame = static_cast<size_t>(bits / 8) * channels;
+			data = body;
+			totalFrames = std::min(chunkSize, mappingSize - (offset + 8)) / bytesPerFrame;
+			return true;
+		}
+
+		offset += 8 + chunkSize + (chunkSize & 1);
+	}
+
+	return false;
+}
+
+// Mintaformtumonknti talakts [-1, 1) tartomny float rtkre
+struct LoadU8  { static float Load(const unsigned char* p) { return (static_cast<int>(p[0]) - 128) / 128.0f; } };
+struct LoadS16 { static float Load(const unsigned char* p) { int16_t v; std::memcpy(&v, p, 2); return v / 32768.0f; } };
+struct LoadS24 { static float Load(const unsigned char* p) { const int32_t v = static_cast<int32_t>((p[0] << 8) | (p[1] << 16) | (static_cast<uint32_t>(p[2]) << 24)); return v / 2147483648.0f; } };
+struct LoadS32 { static float Load(const unsigned char* p) { int32_t v; std::memcpy(&v, p, 4); return v / 2147483648.0f; } };
+struct LoadF32 { static float Load(const unsigned char* p) { float v; std::memcpy(&v, p, 4); return v; } };
+struct LoadF64 { static float Load(const unsigned char* p) { double v; std::memcpy(&v, p, 8); return static_cast<float>(v); } };
+
+template <typename Loader, size_t SampleBytes>
+static void ConvertSamples(const unsigned char* source, const size_t count, float* output)
+{
+	for (size_t i = 0; i < count; i++)
+		output[i] = Loader::Load(source + i * SampleBytes);
+}
+
+size_t MappedWavReader::Convert(float* output, const size_t frames)
+{
+	const size_t count = std::min(frames, segmentEnd - position);
+	const size_t convertFrames = ConvertFrames;
+
+	for (size_t done = 0; done < count; )
+	{
+		const size_t n = std::min(convertFrames, count - done);
+		const unsigned char* source = data + (position + done) * bytesPerFrame;
+		const size_t samples = n * channels;
+
+		if (format == SampleFormat::F32 && reinterpret_cast<uintptr_t>(source) % alignof(float) == 0)
+		{
+			downmixer->Process(reinterpret_cast<const float*>(source), n, output + done);
+			done += n;
+			continue;
+		}
+
+		switch (format)
+		{
+		case SampleFormat::U8:  ConvertSamples<LoadU8, 1>(source, samples, interleaved.data()); break;
+		case SampleFormat::S16: ConvertSamples<LoadS16, 2>(source, samples, interleaved.data()); break;
+		case SampleFormat::S24: ConvertSamples<LoadS24, 3>(source, samples, interleaved.data()); break;
+		case SampleFormat::S32: ConvertSamples<LoadS32, 4>(source, samples, interleaved.data()); break;
+		case SampleFormat::F32: ConvertSamples<LoadF32, 4>(source, samples, interleaved.data()); break;
+		case SampleFormat::F64: ConvertSamples<LoadF64, 8>(source, samples, interleaved.data()); break;
+		}
+
+		downmixer->Process(interleaved.data(), n, output + done);
+		done += n;
+	}
+
+	position += count;
+	ReleaseConsumed();
+	return count;
+}
+
+// A mr feldolgozott lapokat nagyobb darabokban elengedjk, gy hossz fjloknl sem n a
+// rezidens memria (a lapok szksg esetn a fjlbl jra betltdnnek).
+void MappedWavReader::ReleaseConsumed()
+{
+#if !defined(_WIN32)
+	const size_t releaseStep = 8 * 1024 * 1024;
+	const size_t consumed = static_cast<size_t>(data - mapping) + position * bytesPerFrame;
+	if (consumed - releasedBytes < releaseStep)
+		return;
+
+	const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	const size_t end = consumed / pageSize * pageSize;
+	madvise(const_cast<unsigned char*>(mapping) + releasedBytes, end - releasedBytes, MADV_DONTNEED);
+	releasedBytes = end;
+#endif
+}
+
+// Az aktulis szakasz elejre lls: a lekpezsben a keress csak egy index belltsa.
+void MappedWavReader::StartSegment()
+{
+	const Segment& segment = segments[segmentIndex];
+	position = segment.Start;
+	segmentEnd = position + std::min(segment.Count, totalFrames - position);
+
+#if !defined(_WIN32)
+	// A lapok elengedse az j olvassi ponttl folytatdik.
+	const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	releasedBytes = (static_cast<size_t>(data - mapping) + position * bytesPerFrame) / pageSize * pageSize;
+#endif
+
+	if (decimator)
+	{
+		decimator->Reset();
+		decimated.clear();
+		decimatedPosition = 0;
+	}
+}
+
+bool MappedWavReader::NextSegment()
+{
+	if (segmentIndex + 1 >= segments.size())
+		return false;
+
+	segmentIndex++;
+	StartSegment();
+	return true;
+}
+
+size_t MappedWavReader::Read(float* output, const size_t count)
+{
+	// Ritkts nlkl kzvetlenl a hv pufferbe (a Transformer ablakpufferbe) runk.
+	if (!decimator)
+		return Convert(output, count);
+
+	size_t written = 0;
+	while (written < count)
+	{
+		if (decimatedPosition == decimated.size())
+		{
+			const size_t frames = Convert(block.data(), BlockFrames);
+			if (frames == 0)
+				break;
+
+			decimated.clear();
+			decimatedPosition = 0;
+			decimator->Process(block.data(), frames, decimated);
+			continue;
+		}
+
+		const size_t n = std::min(count - written, decimated.size() - decimatedPosition);
+		std::copy(decimated.begin() + decimatedPosition, decimated.begin() + decimatedPosition + n, output + written);
+		decimatedPosition += n;
+		written += n;
+	}
+
+	return written;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <memory>
+
+#include "AudioSource.h"
+#include "Decimator.h"
+#include "Downmixer.h"
+
+// Nulla msolsos gyorstott t tmrtetlen WAV fjlokhoz: a fjlt a memriba kpezzk (mmap /
+// MapViewOfFile), a RIFF/WAVE fejlcet (WAVE_FORMAT_EXTENSIBLE-t is) magunk rtelmezzk, s a
+// mintkat olvasskor, kis (gyorsttrban marad) blokkonknt alaktjuk t s keverjk monv
+// a hv pufferbe; 32 bites lebegpontos fjloknl a lekevers kzvetlenl a lekpezsbl olvas.
+// Tmogatott: 8/16/24/32 bites egsz s 32/64 bites lebegpontos PCM. Minden ms formtumot
+// (s az RF64-et) a libsndfile-os StreamReader kezel.
+class MappedWavReader : public AudioSource
+{
+public:
+	static const size_t BlockFrames = 16384;
+	static const size_t ConvertFrames = 2048;
+
+	// nullptr, ha a fjl nem tmogatott WAV vagy nem kpezhet le - ekkor a libsndfile a tartalk.
+	static std::unique_ptr<MappedWavReader> Open(const std::string& path, const InputSettings& settings = InputSettings());
+	~MappedWavReader() override;
+
+	MappedWavReader(const MappedWavReader&) = delete;
+	MappedWavReader& operator=(const MappedWavReader&) = delete;
+
+	size_t Read(float* output, const size_t count) override;
+	bool NextSegment() override;
+
+	inline unsigned GetSampleRate() const override { return sampleRate; }
+	inline unsigned GetChannels() const override { return channels; }
+	inline size_t GetLength() const override { return length; }
+	inline double GetSegmentStart() const override { return segments[segmentIndex].Start / static_cast<double>(sampleRate * decimationFactor); }
+
+private:
+	enum class SampleFormat { U8, S16, S24, S32, F32, F64 };
+
+	MappedWavReader() = default;
+
+	bool Map(const std::string& path);
+	bool ParseHeader();
+	size_t Convert(float* output, const size_t frames);
+	void ReleaseConsumed();
+	void StartSegment();
+
+	const unsigned char* mapping = nullptr;
+	size_t mappingSize = 0;
+	size_t releasedBytes = 0; // a lekpezs eleje, amelynek lapjait mr elengedtk
+#if defined(_WIN32)
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+#endif
+
+	SampleFormat format = SampleFormat::S16;
+	unsigned sampleRate = 0;
+	unsigned channels = 0;
+	size_t bytesPerFrame = 0;
+	const unsigned char* data = nullptr;
+	size_t totalFrames = 0;
+	size_t position = 0; // a kvetkez beolvasand kpkocka
+	size_t length = 0;
+
+	std::vector<Segment> segments;
+	size_t segmentIndex = 0;
+	size_t segmentEnd = 0; // az aktulis szakasz utni els kpkocka
+
+	std::unique_ptr<Downmixer> downmixer;
+	std::vector<float> interleaved; // talaktott, mg le nem kevert kpkockk
+
+	std::unique_ptr<Decimator> decimator;
+	std::vector<float> block;     // ritkts eltti mon blokk
+	std::vector<float> decimated; // ritktott, mg t nem adott mintk
+	size_t decimatedPosition = 0;
+};
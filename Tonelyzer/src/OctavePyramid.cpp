@@ -0,0 +1,101 @@
+#include <algorithm>
+#include <cmath>
+
+#include "OctavePyramid.h"
+
+const size_t OctavePyramid::FilterReach;
+
+OctavePyramid::OctavePyramid(const size_t levelCount)
+	: levels(std::max<size_t>(levelCount, 1))
+{
+	// Hann-ablakos sinc flsvos szr: a kzps egytthat 0.5, a pros tvolsgak 0-k.
+	const double length = 2.0 * FilterReach + 2.0;
+	double sum = 0.5;
+	for (size_t j = 0; j < taps.size(); j++)
+	{
+		const double t = 2.0 * j + 1.0;
+		const double x = 3.14159265358979323846 * t / 2.0;
+		const double window = 0.5 + 0.5 * std::cos(2.0 * 3.14159265358979323846 * t / length);
+		taps[j] = static_cast<float>(0.5 * std::sin(x) / x * window);
+		sum += 2.0 * taps[j];
+	}
+
+	// Egysgnyi egyenram ersts
+	for (float& tap : taps)
+		tap = static_cast<float>(tap / sum);
+	center = static_cast<float>(0.5 / sum);
+}
+
+void OctavePyramid::Reset()
+{
+	for (Level& level : levels)
+	{
+		level.Start = 0;
+		level.Samples.clear();
+	}
+}
+
+void OctavePyramid::Append(const float* samples, const size_t count)
+{
+	levels[0].Samples.insert(levels[0].Samples.end(), samples, samples + count);
+	for (size_t level = 1; level < levels.size(); level++)
+		Extend(level);
+}
+
+void OctavePyramid::Extend(const size_t level)
+{
+	const Level& source = levels[level - 1];
+	Level& target = levels[level];
+	const size_t sourceEnd = source.Start + source.Samples.size();
+	const size_t first = GetEnd(level);
+	if (2 * first + FilterReach >= sourceEnd)
+		return;
+
+	const size_t last = (sourceEnd - FilterReach - 1) / 2; // az utols szmolhat index
+	target.Samples.resize(target.Samples.size() + (last - first + 1));
+	float* output = target.Samples.data() + (first - target.Start);
+
+	// y[m] = c * x[2m] + sum_t h[t] * (x[2m - t] + x[2m + t]), t = 1, 3, ..., FilterReach
+	size_t m = first;
+	for (; m <= last && 2 * m < source.Start + FilterReach; m++)
+	{
+		// A jel eleje: a 0 eltti mintk nullk (a trolt tartomny ilyenkor mg 0-tl indul).
+		const size_t middle = 2 * m;
+		float sum = center * source.Samples[middle - source.Start];
+		for (size_t j = 0; j < taps.size(); j++)
+		{
+			const size_t t = 2 * j + 1;
+			sum += taps[j] * ((middle >= t ? source.Samples[middle - t - source.Start] : 0.0f) + source.Samples[middle + t - source.Start]);
+		}
+		output[m - first] = sum;
+	}
+
+	// A szr belsejben a trolt mintk kzvetlenl, kifejtett szorzatokkal
+	static_assert(FilterReach == 9, "the unrolled filter below has five tap pairs");
+	const float c = center;
+	const float h0 = taps[0], h1 = taps[1], h2 = taps[2], h3 = taps[3], h4 = taps[4];
+	for (; m <= last; m++)
+	{
+		const float* x = source.Samples.data() + (2 * m - source.Start);
+		output[m - first] = c * x[0] + h0 * (*(x - 1) + x[1]) + h1 * (*(x - 3) + x[3]) + h2 * (*(x - 5) + x[5])
+			+ h3 * (*(x - 7) + x[7]) + h4 * (*(x - 9) + x[9]);
+	}
+}
+
+void OctavePyramid::Discard(const size_t level, size_t first)
+{
+	// A kvetkez szint kvetkez mintjhoz a 2m - FilterReach indextl kellenek a mintk.
+	if (level + 1 < levels.size())
+	{
+		const size_t next = 2 * GetEnd(level + 1);
+		first = std::min(first, next > FilterReach ? next - FilterReach : 0);
+	}
+
+	Level& current = levels[level];
+	if (first <= current.Start)
+		return;
+
+	const size_t count = std::min(first - current.Start, current.Samples.size());
+	current.Samples.erase(current.Samples.begin(), current.Samples.begin() + count);
+	current.Start += count;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+// Oktvonknt kettes ritkts jelpiramis a tbbfelbonts (Schrkhuber-Klapuri fle) konstans Q
+// transzformcihoz. A 0. szint az eredeti jel, az o. szint m. mintja az eredeti jel m * 2^o.
+// mintjhoz tartozik: a flsvos szr szimmetrikus, gy a szintek kztt nincs ksleltets.
+// A szr a bemenete mintavteli frekvencijnak 1/8-ig tereszt, 3/8-tl ~54 dB-lel csillapt; a
+// ritktott szinten gy a frekvencia 1/4-ig a tkrzds nem zavar. A jel eleje eltti mintk nullk.
+class OctavePyramid
+{
+public:
+	// A flsvos szr a kzpponttl ennyi mintra nylik.
+	static const size_t FilterReach = 9;
+
+	explicit OctavePyramid(const size_t levelCount);
+
+	// j, nem folytatlagos jel eltt: minden szint kirl.
+	void Reset();
+	// Eredeti mintk a 0. szint vgre; a ritktott szintek a lehetsges mrtkig tovbbszmoldnak.
+	void Append(const float* samples, const size_t count);
+	// A szint first eltti mintinak eldobsa, amennyiben a kvetkez szint szmolshoz sem kellenek.
+	void Discard(const size_t level, const size_t first);
+
+	// A szint index. mintjtl kezdd trolt mintk
+	inline const float* GetSamples(const size_t level, const size_t index) const { return levels[level].Samples.data() + (index - levels[level].Start); }
+	// A szint els, mg ki nem szmolt indexe
+	inline size_t GetEnd(const size_t level) const { return levels[level].Start + levels[level].Samples.size(); }
+	inline size_t GetLevelCount() const { return levels.size(); }
+
+private:
+	struct Level
+	{
+		size_t Start = 0; // a Samples els elemnek indexe a szinten
+		std::vector<float> Samples;
+	};
+
+	// A level. szint tovbbszmolsa az elz szint mr meglv mintibl
+	void Extend(const size_t level);
+
+	std::vector<Level> levels;
+	float center;
+	std::array<float, FilterReach / 2 + 1> taps; // a kzpponttl 1, 3, ..., FilterReach tvolsgra lv egytthatk (a pros tvolsgak 0-k)
+};
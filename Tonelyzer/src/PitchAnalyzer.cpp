@@ -1,155 +1,285 @@
 #include "PitchAnalyzer.h"
+#include "ChromaMap.h"
+#include "KeyProfiles.h"
 
 const PitchNames PitchAnalyzer::pitchNames
 {
     "C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B"
 };
 
-const PitchHistogram PitchAnalyzer::CmajorProfile
-{
+// Krumhansl-Kessler hangnemprofilok (C dr s c moll)
+static constexpr PitchHistogram KrumhanslMajorProfile
+{ {
     6.35f, 2.23f, 3.48f, 2.33f, 4.38f, 4.09f, 2.52f, 5.19f, 2.39f, 3.66f, 2.29f, 2.88f
-};
+} };
 
-const PitchHistogram PitchAnalyzer::CminorProfile
-{
+static constexpr PitchHistogram KrumhanslMinorProfile
+{ {
     6.33f, 2.68f, 3.52f, 5.38f, 2.60f, 3.53f, 2.54f, 4.75f, 3.98f, 2.69f, 3.34f, 3.17f
-};
+} };
+
+// Temperley (Kostka-Payne korpusz) profilok
+static constexpr PitchHistogram TemperleyMajorProfile
+{ {
+    0.748f, 0.060f, 0.488f, 0.082f, 0.670f, 0.460f, 0.096f, 0.715f, 0.104f, 0.366f, 0.057f, 0.400f
+} };
+
+static constexpr PitchHistogram TemperleyMinorProfile
+{ {
+    0.712f, 0.084f, 0.474f, 0.618f, 0.049f, 0.460f, 0.105f, 0.747f, 0.404f, 0.067f, 0.133f, 0.330f
+} };
+
+// Aarden-Essen (Essen npdalkorpusz) profilok
+static constexpr PitchHistogram AardenMajorProfile
+{ {
+    17.7661f, 0.145624f, 14.9265f, 0.160186f, 19.8049f, 11.3587f, 0.291248f, 22.062f, 0.145624f, 8.15494f, 0.232998f, 4.95122f
+} };
+
+static constexpr PitchHistogram AardenMinorProfile
+{ {
+    18.2648f, 0.737619f, 14.0499f, 16.8599f, 0.702494f, 14.4362f, 0.702494f, 18.6161f, 4.56621f, 1.93186f, 7.37619f, 1.75623f
+} };
+
+// Albrecht-Shanahan profilok
+static constexpr PitchHistogram AlbrechtMajorProfile
+{ {
+    0.238f, 0.006f, 0.111f, 0.006f, 0.137f, 0.094f, 0.016f, 0.214f, 0.009f, 0.080f, 0.008f, 0.081f
+} };
+
+static constexpr PitchHistogram AlbrechtMinorProfile
+{ {
+    0.220f, 0.006f, 0.104f, 0.123f, 0.019f, 0.103f, 0.012f, 0.214f, 0.062f, 0.022f, 0.061f, 0.052f
+} };
+
+// A 24 elforgatott, normlt profil fordtsi idben szmolt mtrixai
+static constexpr KeyProfileMatrix KrumhanslMatrix = KeyProfiles::BuildMatrix(KrumhanslMajorProfile, KrumhanslMinorProfile);
+static constexpr KeyProfileMatrix TemperleyMatrix = KeyProfiles::BuildMatrix(TemperleyMajorProfile, TemperleyMinorProfile);
+static constexpr KeyProfileMatrix AardenMatrix = KeyProfiles::BuildMatrix(AardenMajorProfile, AardenMinorProfile);
+static constexpr KeyProfileMatrix AlbrechtMatrix = KeyProfiles::BuildMatrix(AlbrechtMajorProfile, AlbrechtMinorProfile);
+
+PitchAnalyzer::PitchAnalyzer(const Spectrum& spectrum)
+    : averaged(&spectrum)
+{
+    SetProfiles(std::vector<ProfileSelection>());
+}
 
-PitchAnalyzer::PitchAnalyzer(const AudioData& audioData, const FTdata& fftResult)
-    : fftResult(fftResult), data(audioData) {}
+PitchAnalyzer::PitchAnalyzer(const SpectrumSidecar& sidecar)
+    : sidecar(&sidecar)
+{
+    SetProfiles(std::vector<ProfileSelection>());
+}
 
+// A Spectrum a konstruls utn is feltltdhet (main), ezrt a nzet minden hasznlatkor kszl.
+SpectrumView PitchAnalyzer::GetSpectrum() const
+{
+    return sidecar ? sidecar->GetView() : GetSpectrumView(*averaged);
+}
 
-PitchHistogram PitchAnalyzer::CalculateHistogram(const float referencePitch) const
+bool PitchAnalyzer::CanEstimateTuning() const
 {
-    const size_t halfSize = fftResult.size() / 2;
-    std::array<float, 12> histogram;
-    histogram.fill(0);
+    return GetSpectrum().MagnitudeCount >= 3;
+}
 
-    for (size_t k = 1; k < halfSize; k++)
+const std::vector<PitchAnalyzer::ProfileFamily>& PitchAnalyzer::GetRegistry()
+{
+    static const std::vector<ProfileFamily> registry
     {
-        float f = k * data.SampleRate / (float) fftResult.size();
-        if (f < 20.0f || f > 5000.0f) continue;
-
-        float midi = 69.0f + 12.0f * std::log2(f / referencePitch);
-
-        unsigned loMidi = static_cast<unsigned>(std::floor(midi));
-        unsigned hiMidi = loMidi + 1;
-        float frac = std::fmod(midi, 1.0f);
-        float ampl = std::abs(fftResult[k]);
+        { "krumhansl", "Krumhansl-Kessler", &KrumhanslMatrix },
+        { "temperley", "Temperley", &TemperleyMatrix },
+        { "aarden", "Aarden-Essen", &AardenMatrix },
+        { "albrecht", "Albrecht-Shanahan", &AlbrechtMatrix }
+    };
+    return registry;
+}
 
-        if (loMidi >= 0)
+std::vector<ProfileSelection> PitchAnalyzer::ValidateProfiles(const std::vector<ProfileSelection>& profiles)
+{
+    const std::vector<ProfileFamily>& registry = GetRegistry();
+    std::vector<ProfileSelection> selected;
+    for (const ProfileSelection& profile : profiles)
+    {
+        if (profile.Name == "all")
         {
-            unsigned loPitch = static_cast<unsigned>(loMidi) % 12;
-            histogram[loPitch] += ampl * (1.0f - frac);
+            for (const ProfileFamily& family : registry)
+                selected.push_back({ family.Id, profile.Weight });
         }
-
-        unsigned hiPitch = static_cast<unsigned>(std::round(midi)) % 12;
-        histogram[hiPitch] += ampl * frac;
+        else if (IsKnownProfile(profile.Name))
+            selected.push_back(profile);
+        else
+            std::cerr << "Unknown key profile '" << profile.Name << "', skipping it." << std::endl;
     }
+    return selected;
+}
 
-    return histogram;
+bool PitchAnalyzer::IsKnownProfile(const std::string& name)
+{
+    const std::vector<ProfileFamily>& registry = GetRegistry();
+    return name == "all" || std::any_of(registry.begin(), registry.end(), [&](const ProfileFamily& f) { return name == f.Id; });
 }
 
-KeyPair PitchAnalyzer::CalculateKeyKrumhansl(const PitchHistogram& histogram) const
+void PitchAnalyzer::SetProfiles(const std::vector<ProfileSelection>& profiles)
 {
-    float bestMatch = -FLT_MAX;
+    std::vector<ProfileSelection> selected = ValidateProfiles(profiles);
+    if (selected.empty())
+        selected.push_back({ "krumhansl", 1.0f });
 
-    int key_PitchIndex = 0; // 0-C -> 11-B
-    int key_ScaleIndex = 1; // 0: moll, 1: dr
+    bank = KeyProfileBank();
+    familyNames.clear();
+    familyWeights.clear();
 
-    // Dr sklk ellenrzse
-    for (int i = 0; i < 12; i++)
+    const std::vector<ProfileFamily>& registry = GetRegistry();
+    for (const ProfileSelection& profile : selected)
     {
-        const PitchHistogram curKey = ShiftProfile(CmajorProfile, i);
-        float correlation = GetProfileCorrelation(histogram, curKey);
-
-        if (bestMatch < correlation)
-        {
-            bestMatch = correlation;
-            key_PitchIndex = i;
-            key_ScaleIndex = 1;
-        }
+        auto family = std::find_if(registry.begin(), registry.end(), [&](const ProfileFamily& f) { return profile.Name == f.Id; });
+        bank.Add(*family->Matrix);
+        familyNames.push_back(family->Name);
+        familyWeights.push_back(std::max(profile.Weight, 0.0f));
     }
 
-    // Moll sklk ellenrzse
-    for (int i = 0; i < 12; i++)
+    float weightSum = 0.0f;
+    for (const float weight : familyWeights)
+        weightSum += weight;
+    for (float& weight : familyWeights)
+        weight = weightSum > 0.0f ? weight / weightSum : 1.0f / familyWeights.size();
+}
+
+// Egyetlen mtrix-vektor szorzs az sszes csaldra, majd csaldonknt a legjobb hangnem s
+// a korrelcik slyozott tlagbl az egyttes dnts.
+KeyAnalysis PitchAnalyzer::CalculateKeys(const PitchHistogram& histogram) const
+{
+    std::vector<float> scores;
+    bank.Score(histogram, scores);
+
+    KeyAnalysis analysis;
+    KeyScores ensemble;
+    ensemble.fill(0.0f);
+
+    for (size_t c = 0; c < familyNames.size(); c++)
     {
-        const PitchHistogram curKey = ShiftProfile(CminorProfile, i);
-        float correlation = GetProfileCorrelation(histogram, curKey);
+        const float* familyScores = scores.data() + 24 * c;
 
-        if (bestMatch < correlation)
-        {
-            bestMatch = correlation;
-            key_PitchIndex = i;
-            key_ScaleIndex = 0;
-        }
+        KeyEstimate estimate;
+        estimate.Profile = familyNames[c];
+        estimate.Key = KeyProfiles::GetBestKey(familyScores, &estimate.Score);
+        analysis.Families.push_back(estimate);
+
+        for (size_t r = 0; r < 24; r++)
+            ensemble[r] += familyWeights[c] * familyScores[r];
     }
 
-    return std::pair<int, int>(key_PitchIndex, key_ScaleIndex);
+    analysis.Ensemble.Profile = familyNames.size() == 1 ? familyNames[0] : "Ensemble";
+    analysis.Ensemble.Key = KeyProfiles::GetBestKey(ensemble, &analysis.Ensemble.Score);
+    return analysis;
 }
 
-void PitchAnalyzer::PrintKeyKrumhansl(const KeyPair& keyPair) const
+void PitchAnalyzer::PrintKeys(const KeyAnalysis& analysis) const
 {
-    std::string pitch;
-    try 
+    // Tbb csaldnl csaldonknti rszletezs, az utols sor mindig az (egyttes) eredmny.
+    if (analysis.Families.size() > 1)
     {
-        pitch = GetPitchFromNumber(keyPair.first);
-    }
-    catch (const std::out_of_range& e) 
-    {
-        std::cerr << e.what() << std::endl;
-        std::cerr << "Invalid pitch number! Valid pitch number is from 0 (C) to 11 (B). Displaying pitch 'C'." << std::endl;
-        pitch = pitchNames[0];
+        for (const KeyEstimate& estimate : analysis.Families)
+            std::cout << "  " << estimate.Profile << ": " << GetKeyName(estimate.Key) << " (r = " << estimate.Score << ")" << std::endl;
     }
 
-    std::cout << "Estimated key: " << pitch << " ";
-    std::cout << (keyPair.second == 1 ? "major" : "minor") << std::endl;
+    std::cout << "Estimated key: " << GetKeyName(analysis.Ensemble.Key) << std::endl;
 }
 
-float PitchAnalyzer::GetProfileCorrelation(const PitchHistogram& histogram, const PitchHistogram& profile) const
+
+PitchHistogram PitchAnalyzer::CalculateHistogram(const float referencePitch) const
 {
-    float histogramSum = 0.0f;
-    for (const float value : histogram)
-        histogramSum += value;
-    const float histogramMean = histogramSum / 12.0f;
+    const SpectrumView spectrum = GetSpectrum();
+    std::array<float, 12> histogram;
+    histogram.fill(0);
 
-    float profileSum = 0.0f;
-    for (const float value : profile)
-        profileSum += value;
-    const float profileMean = profileSum / 12.0f;
+    // Hangkzpont spektrum (Goertzel, CQT): a bin-ek (flhangonknt BinsPerSemitone darab) kzvetlenl hangokhoz tartoznak, nincs
+    // log2/fmod lekpezs. A referencia-hangmagassg itt mr a transzformcikor rvnyeslt.
+    if (spectrum.Mode == FTmode::GOERTZEL || spectrum.Mode == FTmode::CQT)
+    {
+        ChromaMap::FoldNotes(spectrum.Bins, spectrum.BinCount, spectrum.FirstMidi, spectrum.BinsPerSemitone, histogram);
+        return histogram;
+    }
+
+    // A bemenet egy vals jel fl-spektruma (n/2+1 bin), n az ablakmret. A bin -> hangosztly
+    // lekpezs konfigurcinknt egyszer szmoldik ki (ChromaMap).
+    ChromaMap::Get(spectrum.SampleRate, spectrum.WindowSize, referencePitch)->Fold(spectrum.Bins, histogram);
 
-    float num = 0.0f;
-    float den = 0.0f;
-    float den_deviationHistogram2 = 0.0f;
-    float den_deviationProfile2   = 0.0f;
+    return histogram;
+}
 
-    for (int i = 0; i < 12; i++)
+// A cscsok helye a log-amplitdkra illesztett parabolval, bin-nl finomabban becslhet. Az eltrsek
+// (-50..+50 cent) krn vett, amplitdval slyozott tlaga a hangols; gy a +-50 cent krli
+// cscsok nem hzzk szt az eredmnyt. Csak azok a bin-ek szmtanak, ahol egy bin legfeljebb harmad
+// flhang szles, mert mlyebben a felbonts tl durva.
+float PitchAnalyzer::EstimateTuning(const float nominalPitch) const
+{
+    const SpectrumView spectrum = GetSpectrum();
+    const float* magnitudes = spectrum.Magnitudes;
+    if (spectrum.MagnitudeCount < 3 || spectrum.WindowSize == 0)
+        return 0.0f;
+
+    const float binWidth = spectrum.SampleRate / static_cast<float>(spectrum.WindowSize);
+    const float minFrequency = std::max(MinAnalysisFrequency, binWidth / (std::pow(2.0f, 1.0f / 36.0f) - 1.0f));
+    const float maxFrequency = std::min(MaxAnalysisFrequency, spectrum.SampleRate / 2.0f);
+    const size_t first = std::max<size_t>(1, static_cast<size_t>(std::ceil(minFrequency / binWidth)));
+    const size_t last = std::min(spectrum.MagnitudeCount - 2, static_cast<size_t>(std::floor(maxFrequency / binWidth)));
+    if (first > last)
+        return 0.0f;
+
+    // A leghangosabb cscsnl 40 dB-lel halkabbakat zajnak tekintjk.
+    const float threshold = 0.01f * *std::max_element(magnitudes + first, magnitudes + last + 1);
+
+    double re = 0.0, im = 0.0;
+    for (size_t k = first; k <= last; k++)
     {
-        // Mennyire trnek el a hisztogram egyes elemei az tlagtl.
-        const float deviationHistogram = histogram[i] - histogramMean;    
-        // Mennyire trnek el a sklaprofil adott hangjai az tlagtl.
-        const float deviationProfile = profile[i] - profileMean;
-
-        num += deviationHistogram * deviationProfile;
-        den_deviationHistogram2 += deviationHistogram * deviationHistogram;
-        den_deviationProfile2   += deviationProfile * deviationProfile;
+        const float m = magnitudes[k];
+        if (m <= threshold || m <= magnitudes[k - 1] || m < magnitudes[k + 1])
+            continue;
+
+        const float a = std::log(magnitudes[k - 1] + 1e-20f);
+        const float b = std::log(m);
+        const float c = std::log(magnitudes[k + 1] + 1e-20f);
+        const float curvature = a - 2.0f * b + c;
+        const float delta = curvature < 0.0f ? 0.5f * (a - c) / curvature : 0.0f;
+
+        const float midi = FrequencyToMidi((k + delta) * binWidth, nominalPitch);
+        const double angle = 2.0 * 3.14159265358979323846 * (midi - std::round(midi));
+        re += m * std::cos(angle);
+        im += m * std::sin(angle);
     }
 
-    den = std::sqrt(den_deviationHistogram2 * den_deviationProfile2);
+    if (re == 0.0 && im == 0.0)
+        return 0.0f;
+    return static_cast<float>(std::atan2(im, re) / (2.0 * 3.14159265358979323846) * 100.0);
+}
 
-    return num / den;
+// Mind a 24 hangnem korrelcija egyetlen mtrix-vektor szorzssal (KeyProfiles::Score)
+KeyPair PitchAnalyzer::CalculateKeyKrumhansl(const PitchHistogram& histogram) const
+{
+    KeyScores scores;
+    KeyProfiles::Score(KrumhanslMatrix, histogram, scores);
+    return KeyProfiles::GetBestKey(scores);
 }
 
-const PitchHistogram PitchAnalyzer::ShiftProfile(const PitchHistogram& profile, const int shiftAmount)
+std::string PitchAnalyzer::GetKeyName(const KeyPair& keyPair)
 {
-    // Ha pp nem toljuk el a sklaprofilt, adjuk vissza az eredetit.
-    if (shiftAmount == 0) return profile;
+    std::string pitch;
+    try
+    {
+        pitch = GetPitchFromNumber(keyPair.first);
+    }
+    catch (const std::out_of_range& e)
+    {
+        std::cerr << e.what() << std::endl;
+        std::cerr << "Invalid pitch number! Valid pitch number is from 0 (C) to 11 (B). Displaying pitch 'C'." << std::endl;
+        pitch = pitchNames[0];
+    }
 
-    // Eltolja a relatv sklaprofilokat az ppen vizsglt alaphangra.
-    PitchHistogram shifted;
-    for (int i = 0; i < 12; i++)
-        shifted[i] = profile[(i + 12 - shiftAmount) % 12];
-    return shifted;
+    return pitch + (keyPair.second == 1 ? " major" : " minor");
+}
+
+void PitchAnalyzer::PrintKeyKrumhansl(const KeyPair& keyPair) const
+{
+    std::cout << "Estimated key: " << GetKeyName(keyPair) << std::endl;
 }
 
 const std::string& PitchAnalyzer::GetPitchFromNumber(const unsigned pitch)
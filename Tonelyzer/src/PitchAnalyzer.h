@@ -1,25 +1,60 @@
 #pragma once
 
 #include "Transformer.h"
+#include "KeyProfiles.h"
+#include "SpectrumSidecar.h"
 
 class PitchAnalyzer
 {
 public:
-	PitchAnalyzer(const AudioData& audioData, const FTdata& fftResult);
+	PitchAnalyzer(const Spectrum& spectrum);
+
+	// Elemzs kzvetlenl egy lekpezett spektrumfjlbl, msols nlkl (a sidecar lettartamig)
+	explicit PitchAnalyzer(const SpectrumSidecar& sidecar);
 
 	PitchHistogram CalculateHistogram(const float referenceFreq = 440.0f) const;
+
+	// Hangolsbecsls az tlagolt amplitdspektrumbl (Spectrum::Magnitudes): a spektrlis cscsok
+	// interpollt frekvencijnak eltrse a nominalPitch-hez tartoz kiegyenltett rcstl, centben.
+	float EstimateTuning(const float nominalPitch = 440.0f) const;
+	bool CanEstimateTuning() const; // van-e tlagolt amplitdspektrum (FFT/DFT md)
 	KeyPair CalculateKeyKrumhansl(const PitchHistogram& histogram) const;
 	void PrintKeyKrumhansl(const KeyPair& keyPair) const;
 
+	// A kirtkelend profilcsaldok (krumhansl, temperley, aarden, albrecht vagy all) s slyaik.
+	// Ismeretlen nv figyelmeztetst ad s kimarad; res lista esetn csak Krumhansl-Kessler.
+	void SetProfiles(const std::vector<ProfileSelection>& profiles);
+
+	// Az "all" kibontsa s az ismeretlen nevek kiszrse (figyelmeztetssel); res eredmny esetn
+	// a SetProfiles Krumhansl-Kesslert hasznl. Tbb elemznl elg egyszer ellenrizni.
+	static std::vector<ProfileSelection> ValidateProfiles(const std::vector<ProfileSelection>& profiles);
+	static bool IsKnownProfile(const std::string& name); // az "all" is ismert
+
+	// Egyetlen hisztogram kirtkelse az sszes kivlasztott csaldra egyszerre
+	KeyAnalysis CalculateKeys(const PitchHistogram& histogram) const;
+	void PrintKeys(const KeyAnalysis& analysis) const;
+
+	static std::string GetKeyName(const KeyPair& keyPair);
+
 private:
-	float GetProfileCorrelation(const PitchHistogram& histogram, const PitchHistogram& profile) const;
-	static const PitchHistogram ShiftProfile(const PitchHistogram& profile, const int shiftAmount);
+	struct ProfileFamily
+	{
+		const char* Id;
+		const char* Name;
+		const KeyProfileMatrix* Matrix;
+	};
+
 	static const std::string& GetPitchFromNumber(const unsigned pitch);
+	static const std::vector<ProfileFamily>& GetRegistry();
 
-	const FTdata& fftResult;
-	const AudioData& data;
+	SpectrumView GetSpectrum() const;
+
+	const Spectrum* averaged = nullptr; // a Transformer kimenete, vagy
+	const SpectrumSidecar* sidecar = nullptr; // egy lekpezett spektrumfjl
 	static const PitchNames pitchNames;
-	static const PitchHistogram CmajorProfile;
-	static const PitchHistogram CminorProfile;
+
+	KeyProfileBank bank;
+	std::vector<std::string> familyNames;
+	std::vector<float> familyWeights; // sszegk 1
 };
 
@@ -1,34 +1,42 @@
 #include "Reader.h"
+#include "MappedWavReader.h"
+#include "StreamReader.h"
 
-AudioData Reader::ReadAudio(const std::string path)
+// A teljes jel (vagy a megadott idszakaszok egyms utn fzve) beolvassa mon formban.
+// A lekevers blokkonknt, a dekdolssal egytt fut, gy az tlapolt, tbbcsatorns jel sosem
+// kerl egszben a memriba.
+AudioData Reader::ReadAudio(const std::string path, const InputSettings& settings)
 {
     AudioData data;
 
-    SNDFILE* file;
-    SF_INFO sfInfo;
-    file = sf_open(path.c_str(), SFM_READ, &sfInfo);
-
-    if (!file)
-        throw std::exception();
+    std::unique_ptr<AudioSource> source = Open(path, settings);
 
     data.SuccessfulRead = true;
     data.Filename = path;
-    data.SampleRate = sfInfo.samplerate;
-    data.Channels = sfInfo.channels;
-
-    data.ReaderData.resize(static_cast<size_t>(sfInfo.frames * sfInfo.channels));
-    sf_read_float(file, data.ReaderData.data(), data.ReaderData.size());
-    sf_close(file);
+    data.SampleRate = source->GetSampleRate();
+    data.Channels = source->GetChannels();
 
-    if (data.Channels == 1) // Mon jel - 1/1 tmsols
-        data.MonoData = std::move(data.ReaderData);
-    else if (data.Channels == 2) // Sztere jel
+    data.MonoData.resize(source->GetLength());
+    size_t count = 0;
+    while (true)
     {
-        data.MonoData.resize(static_cast<size_t>(sfInfo.frames));
-        //Interleaved LR (tlapolt bal-jobb csatorna), egyszer tlagols szerint mon jel kpzse.
-        for (size_t i = 0; i < sfInfo.frames; i++)
-            data.MonoData[i] = (data.ReaderData[i * 2] + data.ReaderData[i * 2 + 1]) / 2.0f;
+        if (count == data.MonoData.size())
+            data.MonoData.resize(std::max<size_t>(2 * count, 65536));
+
+        const size_t read = source->Read(data.MonoData.data() + count, data.MonoData.size() - count);
+        if (read == 0 && !source->NextSegment())
+            break;
+        count += read;
     }
+    data.MonoData.resize(count);
 
     return data;
 }
+
+std::unique_ptr<AudioSource> Reader::Open(const std::string& path, const InputSettings& settings)
+{
+    std::unique_ptr<AudioSource> source = MappedWavReader::Open(path, settings);
+    if (!source)
+        source.reset(new StreamReader(path, settings));
+    return source;
+}
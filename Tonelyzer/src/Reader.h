@@ -2,11 +2,18 @@
 
 #include <sndfile.h>
 
+#include <memory>
+
 #include "Structures.h"
+#include "AudioSource.h"
 
 class Reader
 {
 public:
-	static AudioData ReadAudio(const std::string path);
-};
+	// Sikertelen megnyitsnl kivtelt dob.
+	static AudioData ReadAudio(const std::string path, const InputSettings& settings = InputSettings());
 
+	// Folyamatos bemenet megnyitsa: tmrtetlen WAV-nl memriba kpezett, nulla msolsos olvas,
+	// minden ms formtumnl a libsndfile-os StreamReader. Sikertelen megnyitsnl kivtelt dob.
+	static std::unique_ptr<AudioSource> Open(const std::string& path, const InputSettings& settings = InputSettings());
+};
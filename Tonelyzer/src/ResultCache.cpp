@@ -0,0 +1,336 @@
+#include <cstring>
+#include <stdexcept>
+
+#include "ResultCache.h"
+#include "CQTKernel.h"
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace
+{
+	const char FileMagic[8] = { 'T', 'L', 'Z', 'C', 'A', 'C', 'H', 'E' };
+	const uint32_t RecordMagic = 0x525A4C54u; // "TLZR"
+	const uint32_t FormatVersion = 1;
+
+	// A tartalmi hash-be a fjl elejrl, kzeprl s vgrl kerl egy-egy blokk.
+	const size_t SampleBlockSize = 64 * 1024;
+
+	// Egy rekord adatrsznek fels korltja (a srlt hosszmezk kiszrshez)
+	const uint32_t MaxPayloadSize = 1 << 16;
+
+	template <typename T>
+	void Append(std::string& buffer, const T& value)
+	{
+		buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	void AppendString(std::string& buffer, const std::string& value)
+	{
+		Append(buffer, static_cast<uint32_t>(value.size()));
+		buffer.append(value);
+	}
+
+	void AppendEstimate(std::string& buffer, const KeyEstimate& estimate)
+	{
+		AppendString(buffer, estimate.Profile);
+		Append(buffer, static_cast<int32_t>(estimate.Key.first));
+		Append(buffer, static_cast<int32_t>(estimate.Key.second));
+		Append(buffer, estimate.Score);
+	}
+
+	// Hatrellenrz olvas a rekordok adatrszhez
+	struct PayloadReader
+	{
+		const char* Data;
+		size_t Size;
+		size_t Position = 0;
+
+		template <typename T>
+		bool Read(T& value)
+		{
+			if (Size - Position < sizeof(T))
+				return false;
+			std::memcpy(&value, Data + Position, sizeof(T));
+			Position += sizeof(T);
+			return true;
+		}
+
+		bool ReadString(std::string& value)
+		{
+			uint32_t length;
+			if (!Read(length) || Size - Position < length)
+				return false;
+			value.assign(Data + Position, length);
+			Position += length;
+			return true;
+		}
+
+		bool ReadEstimate(KeyEstimate& estimate)
+		{
+			int32_t pitch, mode;
+			if (!ReadString(estimate.Profile) || !Read(pitch) || !Read(mode) || !Read(estimate.Score))
+				return false;
+			estimate.Key = KeyPair(pitch, mode);
+			return true;
+		}
+	};
+
+	bool Seek(FILE* file, const uint64_t offset)
+	{
+#if defined(_WIN32)
+		return _fseeki64(file, static_cast<long long>(offset), SEEK_SET) == 0;
+#else
+		return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+	}
+}
+
+bool ResultCache::Key::operator==(const Key& other) const
+{
+	return Identity.Size == other.Identity.Size && Identity.ModifiedTime == other.Identity.ModifiedTime
+		&& Identity.ContentHash == other.Identity.ContentHash && Parameters == other.Parameters;
+}
+
+size_t ResultCache::KeyHash::operator()(const Key& key) const
+{
+	// A tartalmi hash mr jl szrt, elg a tbbi mezvel sszekeverni.
+	uint64_t hash = key.Identity.ContentHash ^ (key.Parameters * 0x9E3779B97F4A7C15ull);
+	hash ^= key.Identity.Size + static_cast<uint64_t>(key.Identity.ModifiedTime) * 31;
+	return static_cast<size_t>(hash ^ (hash >> 32));
+}
+
+ResultCache::ResultCache(const std::string& path)
+{
+	Load(path);
+
+	file = std::fopen(path.c_str(), "ab");
+	if (!file)
+		throw std::runtime_error("Cannot open result cache " + path);
+
+	std::fseek(file, 0, SEEK_END);
+	if (std::ftell(file) == 0)
+	{
+		std::fwrite(FileMagic, 1, sizeof(FileMagic), file);
+		std::fflush(file);
+	}
+}
+
+ResultCache::~ResultCache()
+{
+	if (file)
+		std::fclose(file);
+}
+
+void ResultCache::Load(const std::string& path)
+{
+	FILE* input = std::fopen(path.c_str(), "rb");
+	if (!input)
+		return; // mg nem ltezik
+
+	std::vector<char> data;
+	char chunk[1 << 16];
+	size_t read;
+	while ((read = std::fread(chunk, 1, sizeof(chunk), input)) > 0)
+		data.insert(data.end(), chunk, chunk + read);
+	std::fclose(input);
+
+	if (data.size() < sizeof(FileMagic) || std::memcmp(data.data(), FileMagic, sizeof(FileMagic)) != 0)
+	{
+		if (!data.empty())
+			throw std::runtime_error(path + " is not a Tonelyzer result cache");
+		return;
+	}
+
+	// Rekord: varzssz, adathossz, adatrsz, az adatrsz hash-e. Hibs rekordnl a kvetkez
+	// varzssztl folytatjuk.
+	const size_t recordOverhead = 2 * sizeof(uint32_t) + sizeof(uint64_t);
+	size_t position = sizeof(FileMagic);
+	while (data.size() - position >= recordOverhead)
+	{
+		uint32_t magic, payloadSize;
+		std::memcpy(&magic, data.data() + position, sizeof(magic));
+		std::memcpy(&payloadSize, data.data() + position + sizeof(magic), sizeof(payloadSize));
+
+		bool valid = magic == RecordMagic && payloadSize <= MaxPayloadSize && data.size() - position - recordOverhead >= payloadSize;
+		if (valid)
+		{
+			const char* payload = data.data() + position + 2 * sizeof(uint32_t);
+			uint64_t checksum;
+			std::memcpy(&checksum, payload + payloadSize, sizeof(checksum));
+
+			Key key;
+			FileResult result;
+			valid = checksum == HashBytes(payload, payloadSize);
+			if (valid && ParseRecord(payload, payloadSize, key, result))
+				index[key] = std::move(result); // ksbbi rekord fellrja a korbbit
+		}
+
+		position += valid ? recordOverhead + payloadSize : 1;
+	}
+}
+
+bool ResultCache::ParseRecord(const char* data, const size_t size, Key& key, FileResult& result) const
+{
+	PayloadReader reader = { data, size };
+
+	uint32_t version;
+	if (!reader.Read(version) || version != FormatVersion)
+		return false; // ms verzi rekordja: kimarad, jraelemzskor fellrdik
+
+	uint32_t familyCount;
+	if (!reader.Read(key.Identity.Size) || !reader.Read(key.Identity.ModifiedTime) || !reader.Read(key.Identity.ContentHash)
+		|| !reader.Read(key.Parameters) || !reader.Read(result.ReferencePitch) || !reader.Read(result.Histogram)
+		|| !reader.ReadEstimate(result.Keys.Ensemble) || !reader.Read(familyCount))
+		return false;
+
+	result.Keys.Families.resize(familyCount);
+	for (KeyEstimate& estimate : result.Keys.Families)
+		if (!reader.ReadEstimate(estimate))
+			return false;
+
+	return reader.Position == size;
+}
+
+bool ResultCache::GetFileIdentity(const std::string& path, FileIdentity& identity)
+{
+#if defined(_WIN32)
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (!GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &attributes))
+		return false;
+	identity.Size = (static_cast<uint64_t>(attributes.nFileSizeHigh) << 32) | attributes.nFileSizeLow;
+	identity.ModifiedTime = static_cast<int64_t>((static_cast<uint64_t>(attributes.ftLastWriteTime.dwHighDateTime) << 32) | attributes.ftLastWriteTime.dwLowDateTime);
+
+	const HANDLE handle = CreateFileA(path.c_str(), FILE_READ_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (handle != INVALID_HANDLE_VALUE)
+	{
+		BY_HANDLE_FILE_INFORMATION information;
+		if (GetFileInformationByHandle(handle, &information))
+			identity.FileId = (static_cast<uint64_t>(information.nFileIndexHigh) << 32) | information.nFileIndexLow;
+		CloseHandle(handle);
+	}
+#else
+	struct stat info;
+	if (stat(path.c_str(), &info) != 0)
+		return false;
+	identity.Size = static_cast<uint64_t>(info.st_size);
+	identity.ModifiedTime = static_cast<int64_t>(info.st_mtime);
+	identity.FileId = static_cast<uint64_t>(info.st_ino);
+#endif
+
+	FILE* input = std::fopen(path.c_str(), "rb");
+	if (!input)
+		return false;
+
+	// Kis fjlnl az egsz, egybknt az elejrl, a kzeprl s a vgrl egy-egy blokk
+	std::vector<char> block(SampleBlockSize);
+	uint64_t hash = HashBytes(&identity.Size, sizeof(identity.Size));
+	const uint64_t offsets[] = { 0, identity.Size / 2 - SampleBlockSize / 2, identity.Size - SampleBlockSize };
+	const size_t blockCount = identity.Size <= 3 * SampleBlockSize ? 1 : 3;
+	bool success = true;
+	for (size_t i = 0; i < blockCount && success; i++)
+	{
+		success = Seek(input, offsets[i]);
+		while (success)
+		{
+			const size_t read = std::fread(block.data(), 1, block.size(), input);
+			hash = HashBytes(block.data(), read, hash);
+			if (blockCount == 3 || read < block.size())
+				break;
+		}
+		success = success && !std::ferror(input);
+	}
+	std::fclose(input);
+
+	identity.ContentHash = hash;
+	return success;
+}
+
+uint64_t ResultCache::GetParameterHash(const InitData& init)
+{
+	std::string parameters;
+	Append(parameters, FormatVersion);
+	Append(parameters, static_cast<int32_t>(init.FourierMode));
+	Append(parameters, init.FTWindowSize);
+	Append(parameters, static_cast<int32_t>(init.Window));
+	Append(parameters, init.BinsPerSemitone);
+	Append(parameters, init.ReferencePitch);
+	Append(parameters, static_cast<uint8_t>(init.EstimateTuning));
+	if (init.FourierMode == FTmode::CQT)
+		Append(parameters, CQTKernel::Revision);
+
+	Append(parameters, static_cast<uint8_t>(init.Input.Decimate));
+	Append(parameters, static_cast<int32_t>(init.Input.Downmix.Type));
+	Append(parameters, static_cast<uint32_t>(init.Input.Downmix.Weights.size()));
+	for (const float weight : init.Input.Downmix.Weights)
+		Append(parameters, weight);
+	Append(parameters, static_cast<uint32_t>(init.Input.Ranges.size()));
+	for (const TimeRange& range : init.Input.Ranges)
+	{
+		Append(parameters, range.Start);
+		Append(parameters, range.Duration);
+	}
+
+	Append(parameters, static_cast<uint32_t>(init.Profiles.size()));
+	for (const ProfileSelection& profile : init.Profiles)
+	{
+		AppendString(parameters, profile.Name);
+		Append(parameters, profile.Weight);
+	}
+
+	return HashBytes(parameters.data(), parameters.size());
+}
+
+bool ResultCache::Find(const FileIdentity& identity, const uint64_t parameters, FileResult& result) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	const auto entry = index.find({ identity, parameters });
+	if (entry == index.end())
+		return false;
+
+	const std::string path = result.Path;
+	result = entry->second;
+	result.Path = path;
+	return true;
+}
+
+void ResultCache::Store(const FileIdentity& identity, const uint64_t parameters, const FileResult& result)
+{
+	std::string payload;
+	Append(payload, FormatVersion);
+	Append(payload, identity.Size);
+	Append(payload, identity.ModifiedTime);
+	Append(payload, identity.ContentHash);
+	Append(payload, parameters);
+	Append(payload, result.ReferencePitch);
+	Append(payload, result.Histogram);
+	AppendEstimate(payload, result.Keys.Ensemble);
+	Append(payload, static_cast<uint32_t>(result.Keys.Families.size()));
+	for (const KeyEstimate& estimate : result.Keys.Families)
+		AppendEstimate(payload, estimate);
+
+	std::string record;
+	Append(record, RecordMagic);
+	Append(record, static_cast<uint32_t>(payload.size()));
+	record += payload;
+	Append(record, HashBytes(payload.data(), payload.size()));
+
+	std::lock_guard<std::mutex> lock(mutex);
+	FileResult& entry = index[{ identity, parameters }];
+	entry = result;
+	entry.Path.clear();
+
+	// Egyetlen rs s azonnali rts, hogy egy msik folyamat rekordjai ne keldjenek bele.
+	std::fwrite(record.data(), 1, record.size(), file);
+	std::fflush(file);
+}
+
+size_t ResultCache::GetEntryCount() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return index.size();
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <unordered_map>
+
+#include "Structures.h"
+
+// Egy hangfjl azonostja: mret, mdostsi id s nhny mintavtelezett blokk tartalmi hash-e.
+// A tartalmi hash miatt egy visszalltott mdostsi id vagy egy azonos mret csere is kiderl,
+// a teljes fjl beolvassa nlkl. A fjlrendszerbeli azonost (inode, ill. Windows alatt a
+// fjlindex) csak a spektrumfjlok ellenrzsben szerepel; a gyorsttr rekordjaiban nincs benne.
+struct FileIdentity
+{
+	uint64_t Size = 0;
+	int64_t ModifiedTime = 0;
+	uint64_t ContentHash = 0;
+	uint64_t FileId = 0;
+};
+
+// Elemzsi eredmnyek tarts, tartalom szerint cmzett gyorsttra egyetlen fjlban. A kulcs a
+// fjl azonostja s az eredmnyt befolysol paramterek (FTmode, ablakmret s -fggvny,
+// referencia-hangmagassg, profilok, bemeneti belltsok) hash-e; az rtk a hisztogram s a
+// hangnembecsls.
+// A fjl csak bvl: minden rekord egy varzsszval kezddik s ellenrzsszeggel zrul, gy egy
+// flbeszakadt rs csak az adott rekordot rinti, a betlts a kvetkez varzssznl folytatdik.
+// Megnyitskor az egsz fjl bekerl egy memriabeli indexbe. A Find s a Store tbb szlrl is
+// hvhat, s egy rekord egyetlen rssal kerl a hozzfzsre megnyitott fjl vgre, gy
+// prhuzamos folyamatok is hasznlhatjk ugyanazt a fjlt (a msik folyamat j rekordjait csak a
+// kvetkez megnyitskor ltja).
+class ResultCache
+{
+public:
+	// Sikertelen megnyitsnl kivtelt dob.
+	explicit ResultCache(const std::string& path);
+	~ResultCache();
+
+	ResultCache(const ResultCache&) = delete;
+	ResultCache& operator=(const ResultCache&) = delete;
+
+	// false, ha a fjl nem olvashat
+	static bool GetFileIdentity(const std::string& path, FileIdentity& identity);
+
+	// Az eredmnyt befolysol belltsok hash-e (a kimeneti s szlszm-kapcsolk nem szmtanak)
+	static uint64_t GetParameterHash(const InitData& init);
+
+	// Tallat esetn a result a trolt eredmny (a Path kivtelvel)
+	bool Find(const FileIdentity& identity, const uint64_t parameters, FileResult& result) const;
+	void Store(const FileIdentity& identity, const uint64_t parameters, const FileResult& result);
+
+	size_t GetEntryCount() const;
+
+private:
+	struct Key
+	{
+		FileIdentity Identity;
+		uint64_t Parameters;
+
+		bool operator==(const Key& other) const;
+	};
+
+	struct KeyHash
+	{
+		size_t operator()(const Key& key) const;
+	};
+
+	void Load(const std::string& path);
+	bool ParseRecord(const char* data, const size_t size, Key& key, FileResult& result) const;
+
+	FILE* file = nullptr;
+	std::unordered_map<Key, FileResult, KeyHash> index;
+	mutable std::mutex mutex;
+};
@@ -0,0 +1,49 @@
+#include "Simd.h"
+
+#if defined(TONELYZER_X86_SIMD) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+static CpuFeatures DetectCpuFeatures()
+{
+	CpuFeatures features;
+
+#if defined(TONELYZER_X86_SIMD)
+	features.SSE2 = true; // x86-64 alapkszlet
+
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	const int maxLeaf = info[0];
+
+	__cpuid(info, 1);
+	const bool osxsave = (info[2] & (1 << 27)) != 0;
+	const bool fma     = (info[2] & (1 << 12)) != 0;
+
+	// Az opercis rendszernek is mentenie kell az YMM regisztereket.
+	const bool ymmEnabled = osxsave && ((_xgetbv(0) & 0x6) == 0x6);
+
+	bool avx2 = false;
+	if (maxLeaf >= 7)
+	{
+		__cpuidex(info, 7, 0);
+		avx2 = (info[1] & (1 << 5)) != 0;
+	}
+
+	features.AVX2 = avx2 && ymmEnabled;
+	features.FMA  = fma && ymmEnabled;
+#else
+	__builtin_cpu_init();
+	features.AVX2 = __builtin_cpu_supports("avx2") != 0;
+	features.FMA  = __builtin_cpu_supports("fma") != 0;
+#endif
+#endif
+
+	return features;
+}
+
+const CpuFeatures& GetCpuFeatures()
+{
+	static const CpuFeatures features = DetectCpuFeatures();
+	return features;
+}
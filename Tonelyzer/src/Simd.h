@@ -0,0 +1,26 @@
+#pragma once
+
+// SIMD tmogats: x86-64 alatt SSE2 mindig elrhet, az AVX2/FMA kdutakat
+// futsidben, a processzor kpessgei alapjn vlasztjuk ki.
+#if defined(_M_X64) || defined(__x86_64__)
+#define TONELYZER_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+// GCC/Clang alatt az AVX2-es fggvnyeket kln clarchitektrval kell fordtani,
+// MSVC alatt az intrinsic-ek fordtsi kapcsol nlkl is hasznlhatk.
+#if defined(TONELYZER_X86_SIMD) && (defined(__GNUC__) || defined(__clang__))
+#define TONELYZER_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define TONELYZER_TARGET_AVX2
+#endif
+
+struct CpuFeatures
+{
+	bool SSE2 = false;
+	bool AVX2 = false;
+	bool FMA  = false;
+};
+
+// Egyszer felismert, utna gyorsttrazott CPU-kpessgek.
+const CpuFeatures& GetCpuFeatures();
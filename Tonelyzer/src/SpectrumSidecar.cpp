@@ -0,0 +1,253 @@
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+#include "SpectrumSidecar.h"
+#include "CQTKernel.h"
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	const char FileMagic[8] = { 'T', 'L', 'Z', 'S', 'P', 'E', 'C', '\0' };
+	const uint32_t FormatVersion = 2;
+
+	struct SidecarHeader
+	{
+		char Magic[8];
+		uint32_t Version;
+		uint32_t Mode;
+		uint32_t SampleRate;
+		uint32_t WindowSize;
+		float ReferencePitch;
+		int32_t FirstMidi;
+		uint32_t BinsPerSemitone;
+		uint32_t Reserved;
+		uint64_t BinCount;
+		uint64_t MagnitudeCount;
+		uint64_t FileSize;
+		uint64_t ContentHash;
+		uint64_t Parameters;
+		int64_t ModifiedTime;
+		uint64_t FileId;
+		char Padding[32];
+	};
+
+	static_assert(sizeof(SidecarHeader) == SpectrumSidecar::HeaderSize, "The sidecar header must be exactly HeaderSize bytes");
+
+	template <typename T>
+	uint64_t HashValue(const T& value, const uint64_t hash)
+	{
+		return HashBytes(&value, sizeof(T), hash);
+	}
+}
+
+std::unique_ptr<SpectrumSidecar> SpectrumSidecar::Open(const std::string& path, const FileIdentity& identity, const uint64_t parameters)
+{
+	std::unique_ptr<SpectrumSidecar> sidecar(new SpectrumSidecar());
+	if (!sidecar->Map(path) || !sidecar->ParseHeader(identity, parameters))
+		return nullptr;
+	return sidecar;
+}
+
+SpectrumSidecar::~SpectrumSidecar()
+{
+#if defined(_WIN32)
+	if (mapping)
+		UnmapViewOfFile(mapping);
+	if (mappingHandle)
+		CloseHandle(mappingHandle);
+	if (fileHandle && fileHandle != INVALID_HANDLE_VALUE)
+		CloseHandle(fileHandle);
+#else
+	if (mapping)
+		munmap(const_cast<unsigned char*>(mapping), mappingSize);
+#endif
+}
+
+bool SpectrumSidecar::Map(const std::string& path)
+{
+#if defined(_WIN32)
+	fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (fileHandle == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(fileHandle, &size) || size.QuadPart < static_cast<LONGLONG>(HeaderSize))
+		return false;
+	mappingSize = static_cast<size_t>(size.QuadPart);
+
+	mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mappingHandle)
+		return false;
+
+	mapping = static_cast<const unsigned char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+	return mapping != nullptr;
+#else
+	const int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(HeaderSize))
+	{
+		close(fd);
+		return false;
+	}
+	mappingSize = static_cast<size_t>(info.st_size);
+
+	void* address = mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (address == MAP_FAILED)
+		return false;
+
+	mapping = static_cast<const unsigned char*>(address);
+	return true;
+#endif
+}
+
+bool SpectrumSidecar::ParseHeader(const FileIdentity& identity, const uint64_t parameters)
+{
+	SidecarHeader header;
+	std::memcpy(&header, mapping, sizeof(header));
+
+	if (std::memcmp(header.Magic, FileMagic, sizeof(FileMagic)) != 0 || header.Version != FormatVersion)
+		return false;
+	// A mdostsi id s az inode a mintavtelezett tartalmi hash ltal nem ltott szerkesztseket
+	// (s a helyre msolt msik fjlt) is kiszri.
+	if (header.FileSize != identity.Size || header.ContentHash != identity.ContentHash || header.Parameters != parameters
+		|| header.ModifiedTime != identity.ModifiedTime || header.FileId != identity.FileId)
+		return false;
+
+	// A tmbk hossza pontosan ki kell, hogy tltse a fjlt (flbeszakadt vagy idegen fjl kiszrse).
+	const size_t available = mappingSize - HeaderSize;
+	if (header.BinCount > available / sizeof(std::complex<float>)
+		|| header.MagnitudeCount > available / sizeof(float)
+		|| header.BinCount * sizeof(std::complex<float>) + header.MagnitudeCount * sizeof(float) != available)
+		return false;
+
+	const FTmode mode = static_cast<FTmode>(header.Mode);
+	if (mode == FTmode::FFT || mode == FTmode::DFT)
+	{
+		// A ChromaMap a fl-spektrum teljes hosszt felttelezi.
+		if (header.WindowSize < 2 || header.BinCount != header.WindowSize / 2 + 1 || (header.MagnitudeCount != 0 && header.MagnitudeCount != header.BinCount))
+			return false;
+	}
+	else if ((mode != FTmode::GOERTZEL && mode != FTmode::CQT) || header.BinsPerSemitone == 0)
+		return false;
+
+	view.Mode = mode;
+	view.Bins = reinterpret_cast<const std::complex<float>*>(mapping + HeaderSize);
+	view.BinCount = static_cast<size_t>(header.BinCount);
+	view.SampleRate = header.SampleRate;
+	view.WindowSize = header.WindowSize;
+	view.ReferencePitch = header.ReferencePitch;
+	view.FirstMidi = header.FirstMidi;
+	view.BinsPerSemitone = header.BinsPerSemitone;
+	view.Magnitudes = header.MagnitudeCount > 0 ? reinterpret_cast<const float*>(view.Bins + view.BinCount) : nullptr;
+	view.MagnitudeCount = static_cast<size_t>(header.MagnitudeCount);
+	return true;
+}
+
+static unsigned long CurrentProcessId()
+{
+#if defined(_WIN32)
+	return static_cast<unsigned long>(GetCurrentProcessId());
+#else
+	return static_cast<unsigned long>(getpid());
+#endif
+}
+
+bool SpectrumSidecar::Write(const std::string& path, const FileIdentity& identity, const uint64_t parameters, const Spectrum& spectrum)
+{
+	SidecarHeader header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.Magic, FileMagic, sizeof(FileMagic));
+	header.Version = FormatVersion;
+	header.Mode = static_cast<uint32_t>(spectrum.Mode);
+	header.SampleRate = spectrum.SampleRate;
+	header.WindowSize = spectrum.WindowSize;
+	header.ReferencePitch = spectrum.ReferencePitch;
+	header.FirstMidi = spectrum.FirstMidi;
+	header.BinsPerSemitone = spectrum.BinsPerSemitone;
+	header.BinCount = spectrum.Bins.size();
+	header.MagnitudeCount = spectrum.Magnitudes.size();
+	header.FileSize = identity.Size;
+	header.ContentHash = identity.ContentHash;
+	header.Parameters = parameters;
+	header.ModifiedTime = identity.ModifiedTime;
+	header.FileId = identity.FileId;
+
+	// Folyamatonknt s szlanknt egyedi ideiglenes nv, hogy sem a ktegelt md prhuzamos rsai, sem
+	// az ugyanazt a knyvtrat hasznl, egyszerre fut pldnyok ne akadjanak ssze.
+	const std::string temporary = path + ".tmp" + std::to_string(CurrentProcessId()) + "-"
+		+ std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+	FILE* file = std::fopen(temporary.c_str(), "wb");
+	if (!file)
+		return false;
+
+	bool success = std::fwrite(&header, sizeof(header), 1, file) == 1;
+	if (success && !spectrum.Bins.empty())
+		success = std::fwrite(spectrum.Bins.data(), sizeof(std::complex<float>), spectrum.Bins.size(), file) == spectrum.Bins.size();
+	if (success && !spectrum.Magnitudes.empty())
+		success = std::fwrite(spectrum.Magnitudes.data(), sizeof(float), spectrum.Magnitudes.size(), file) == spectrum.Magnitudes.size();
+	success = std::fclose(file) == 0 && success;
+
+	// A Windows-os rename nem rja fell a ltez clfjlt.
+	if (success)
+	{
+		std::remove(path.c_str());
+		success = std::rename(temporary.c_str(), path.c_str()) == 0;
+	}
+	if (!success)
+		std::remove(temporary.c_str());
+	return success;
+}
+
+std::string SpectrumSidecar::GetPath(const std::string& audioPath, const std::string& directory, const FileIdentity& identity, const uint64_t parameters)
+{
+	char name[64];
+	if (directory.empty())
+	{
+		std::snprintf(name, sizeof(name), ".%016llx.tlzs", static_cast<unsigned long long>(parameters));
+		return audioPath + name;
+	}
+
+	std::snprintf(name, sizeof(name), "%016llx-%016llx.tlzs", static_cast<unsigned long long>(identity.ContentHash), static_cast<unsigned long long>(parameters));
+	const char last = directory.back();
+	return last == '/' || last == '\\' ? directory + name : directory + "/" + name;
+}
+
+uint64_t SpectrumSidecar::GetParameterHash(const InitData& init)
+{
+	uint64_t hash = HashValue(FormatVersion, 14695981039346656037ull);
+	hash = HashValue(static_cast<int32_t>(init.FourierMode), hash);
+	hash = HashValue(init.FTWindowSize, hash);
+	hash = HashValue(static_cast<int32_t>(init.Window), hash);
+	hash = HashValue(init.BinsPerSemitone, hash);
+	if (init.FourierMode == FTmode::GOERTZEL || init.FourierMode == FTmode::CQT)
+		hash = HashValue(init.ReferencePitch, hash);
+	if (init.FourierMode == FTmode::CQT)
+		hash = HashValue(CQTKernel::Revision, hash);
+
+	hash = HashValue(static_cast<uint8_t>(init.Input.Decimate), hash);
+	hash = HashValue(static_cast<int32_t>(init.Input.Downmix.Type), hash);
+	hash = HashValue(static_cast<uint32_t>(init.Input.Downmix.Weights.size()), hash);
+	for (const float weight : init.Input.Downmix.Weights)
+		hash = HashValue(weight, hash);
+	hash = HashValue(static_cast<uint32_t>(init.Input.Ranges.size()), hash);
+	for (const TimeRange& range : init.Input.Ranges)
+	{
+		hash = HashValue(range.Start, hash);
+		hash = HashValue(range.Duration, hash);
+	}
+	return hash;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <memory>
+
+#include "Structures.h"
+#include "ResultCache.h"
+
+// Az tlagolt spektrum (Transformer::AvgFourier kimenete) tarts trolsa egy kis, verzizott,
+// memriba kpezhet fjlban. A spektrum csak a hangtl s a transzformci belltsaitl fgg,
+// gy a referencia-hangmagassg (FFT/DFT mdban) vagy a profilok megvltoztatsakor a dekdols s a
+// transzformci kihagyhat, csak a hisztogram s a korrelci szmoldik jra.
+// Formtum: 128 bjtos fejlc (varzssz, verzi, a Spectrum skalr mezi, a hangfjl mrete,
+// tartalmi hash-e, mdostsi ideje s inode-ja, a paramterek hash-e, a tmbk hossza), utna a
+// bin-ek (komplex float32, a 128. bjttl), majd az tlagolt amplitdk (float32, ha vannak). A
+// tartalmi hash csak mintavtelezett blokkokbl ll, ezrt a mdostsi id vagy az inode eltrse is
+// rvnytelenti a spektrumot; egy csak "megrintett" fjlnl ez egy flsleges jraszmols.
+class SpectrumSidecar
+{
+public:
+	static const size_t HeaderSize = 128;
+
+	// nullptr, ha a fjl nem ltezik, srlt, ms verzij, vagy nem ehhez a hanghoz s paramterekhez tartozik.
+	static std::unique_ptr<SpectrumSidecar> Open(const std::string& path, const FileIdentity& identity, const uint64_t parameters);
+
+	// Kirs ideiglenes fjlba, majd tnevezs, hogy olvas soha ne lsson flksz fjlt; false hiba esetn.
+	static bool Write(const std::string& path, const FileIdentity& identity, const uint64_t parameters, const Spectrum& spectrum);
+
+	// res directory esetn a hangfjl mellett "<hangfjl>.<paramterhash>.tlzs", egybknt
+	// "<directory>/<tartalmi hash>-<paramterhash>.tlzs".
+	static std::string GetPath(const std::string& audioPath, const std::string& directory, const FileIdentity& identity, const uint64_t parameters);
+
+	// A transzformci kimenett meghatroz belltsok hash-e (a referencia-hangmagassg csak a
+	// hangkzpont mdokban szmt, a profilok soha)
+	static uint64_t GetParameterHash(const InitData& init);
+
+	~SpectrumSidecar();
+
+	SpectrumSidecar(const SpectrumSidecar&) = delete;
+	SpectrumSidecar& operator=(const SpectrumSidecar&) = delete;
+
+	// A lekpezsre mutat nzet; a SpectrumSidecar lettartamig rvnyes.
+	inline const SpectrumView& GetView() const { return view; }
+
+private:
+	SpectrumSidecar() = default;
+
+	bool Map(const std::string& path);
+	bool ParseHeader(const FileIdentity& identity, const uint64_t parameters);
+
+	const unsigned char* mapping = nullptr;
+	size_t mappingSize = 0;
+#if defined(_WIN32)
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+#endif
+
+	SpectrumView view;
+};
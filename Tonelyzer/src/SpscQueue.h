@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+// Rgztett kapacits sor pontosan egy termel s egy fogyaszt szl kztt.
+// A termel csak a tail, a fogyaszt csak a head indexet rja; a release/acquire prok biztostjk,
+// hogy a bert elem a fogyaszt szmra a tail nvelse eltt lthat legyen. A TryPush/TryPop zr
+// nlkli; a blokkol Push/Pop tele, ill. res sornl egy felttelvltozn alszik, amg a msik oldal
+// nem lp, vagy a sort le nem zrjk (Close), gy a vrakoz szl nem foglal processzormagot.
+template <typename T>
+class SpscQueue
+{
+public:
+	explicit SpscQueue(const size_t capacity)
+		: slots(capacity + 1) {}
+
+	SpscQueue(const SpscQueue&) = delete;
+	SpscQueue& operator=(const SpscQueue&) = delete;
+
+	// Csak a termel szlrl hvhat. Tele sor esetn false, az elem rintetlen marad.
+	bool TryPush(T& item)
+	{
+		const size_t t = tail.Value.load(std::memory_order_relaxed);
+		const size_t next = (t + 1) % slots.size();
+		if (next == head.Value.load(std::memory_order_acquire))
+			return false;
+
+		slots[t] = std::move(item);
+		tail.Value.store(next, std::memory_order_release);
+		Notify();
+		return true;
+	}
+
+	// Csak a fogyaszt szlrl hvhat. res sor esetn false.
+	bool TryPop(T& item)
+	{
+		const size_t h = head.Value.load(std::memory_order_relaxed);
+		if (h == tail.Value.load(std::memory_order_acquire))
+			return false;
+
+		item = std::move(slots[h]);
+		head.Value.store((h + 1) % slots.size(), std::memory_order_release);
+		Notify();
+		return true;
+	}
+
+	// Tele sornl vr; a lezrt sorba nem tesz, ekkor false.
+	bool Push(T& item)
+	{
+		while (!closed.load(std::memory_order_acquire))
+		{
+			if (TryPush(item))
+				return true;
+			std::unique_lock<std::mutex> lock(mutex);
+			changed.wait(lock, [&]() { return closed.load(std::memory_order_acquire) || !IsFull(); });
+		}
+		return false;
+	}
+
+	// res sornl vr; a lezrt sorbl mg kiveszi a benne maradt elemeket, utna false.
+	bool Pop(T& item)
+	{
+		while (true)
+		{
+			if (TryPop(item))
+				return true;
+			if (closed.load(std::memory_order_acquire))
+				return TryPop(item);
+			std::unique_lock<std::mutex> lock(mutex);
+			changed.wait(lock, [&]() { return closed.load(std::memory_order_acquire) || !IsEmpty(); });
+		}
+	}
+
+	// A termels vge (vagy lellts): a vrakoz Push/Pop hvsok felbrednek.
+	void Close()
+	{
+		closed.store(true, std::memory_order_release);
+		Notify();
+	}
+
+private:
+	// A head s a tail kln gyorsttr-sorba kerl; alignas helyett kitltssel, mert a
+	// C++17 eltti operator new a 64 bjtos igaztst nem tartja be.
+	struct PaddedIndex
+	{
+		std::atomic<size_t> Value{ 0 };
+		char Padding[64 - sizeof(std::atomic<size_t>)];
+	};
+
+	bool IsFull() const
+	{
+		return (tail.Value.load(std::memory_order_acquire) + 1) % slots.size() == head.Value.load(std::memory_order_acquire);
+	}
+
+	bool IsEmpty() const
+	{
+		return head.Value.load(std::memory_order_acquire) == tail.Value.load(std::memory_order_acquire);
+	}
+
+	// A zr a vrakoz oldal felttelvizsglata s elalvsa kztti jelzst nem engedi elveszni.
+	void Notify()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+		}
+		changed.notify_all();
+	}
+
+	std::vector<T> slots;
+	PaddedIndex head;
+	PaddedIndex tail;
+	std::atomic<bool> closed{ false };
+	std::mutex mutex;
+	std::condition_variable changed;
+};
@@ -0,0 +1,200 @@
+#include <stdexcept>
+
+#include "StreamReader.h"
+
+StreamReader::StreamReader(const std::string& path, const InputSettings& settings)
+	: filled(BlockCount), recycled(BlockCount)
+{
+	SF_INFO sfInfo = {};
+	file = sf_open(path.c_str(), SFM_READ, &sfInfo);
+	if (!file)
+		throw std::runtime_error(sf_strerror(nullptr));
+
+	filename = path;
+	sampleRate = sfInfo.samplerate;
+	channels = sfInfo.channels;
+	downmixer.reset(new Downmixer(channels, settings.Downmix));
+
+	const size_t frames = sfInfo.frames > 0 ? static_cast<size_t>(sfInfo.frames) : 0;
+	segments = GetSegments(settings.Ranges, sampleRate, frames);
+	length = GetSegmentsLength(segments, frames);
+
+	if (settings.Decimate)
+	{
+		decimator.reset(new Decimator(sampleRate));
+		decimationFactor = decimator->GetFactor();
+		sampleRate = decimator->GetOutputSampleRate();
+		length /= decimator->GetFactor();
+	}
+
+	interleaved.resize(BlockFrames * channels);
+	mono.resize(BlockFrames);
+
+	if (!settings.BackgroundDecode)
+		return;
+
+	for (size_t i = 0; i < BlockCount; i++)
+	{
+		Block block;
+		block.Samples.reserve(BlockFrames);
+		recycled.TryPush(block);
+	}
+
+	decoder = std::thread(&StreamReader::DecodeLoop, this);
+}
+
+StreamReader::~StreamReader()
+{
+	stopping = true;
+	recycled.Close();
+	filled.Close();
+	if (decoder.joinable())
+		decoder.join();
+	sf_close(file);
+}
+
+// res blokk krse a kszletbl; ha az elemz lemaradt, alv vrakozssal megvrjuk.
+bool StreamReader::AcquireBlock(Block& block)
+{
+	if (stopping || !recycled.Pop(block))
+		return false;
+	block.Samples.clear();
+	block.SegmentEnd = false;
+	return true;
+}
+
+// Tele sornl alv vrakozs; lelltskor (lezrt sor) false.
+bool StreamReader::SubmitBlock(Block& block)
+{
+	return filled.Push(block);
+}
+
+void StreamReader::DecodeLoop()
+{
+	Block block;
+	while (AcquireBlock(block))
+	{
+		if (!DecodeNext(block))
+			break;
+		if (!SubmitBlock(block))
+			return;
+	}
+
+	filled.Close();
+}
+
+// A kvetkez blokk dekdolsa a blokkba, a szakasz vgn a szakaszvge-jelz; false, ha nincs tbb
+// szakasz. Csak a dekdolst vgz szlrl (httrszl, ill. szl nlkl az elemz) hvhat.
+bool StreamReader::DecodeNext(Block& block)
+{
+	if (decodeSegment >= segments.size())
+		return false;
+
+	if (!segmentOpen)
+	{
+		const Segment& segment = segments[decodeSegment];
+
+		// A teljes fjl olvassakor nincs keress, gy nem kereshet bemenet is olvashat.
+		bool readable = true;
+		if (decodeSegment > 0 || segment.Start > 0)
+		{
+			if (sf_seek(file, static_cast<sf_count_t>(segment.Start), SEEK_SET) < 0)
+			{
+				std::cerr << "Cannot seek to frame " << segment.Start << " in " << filename << ", skipping the range." << std::endl;
+				readable = false;
+			}
+		}
+
+		if (decimator)
+			decimator->Reset();
+
+		remaining = readable ? segment.Count : 0;
+		segmentOpen = true;
+	}
+
+	if (remaining > 0)
+	{
+		const size_t blockFrames = BlockFrames; // a std::min ne hivatkozzon az osztlyszint konstansra
+		const sf_count_t frames = sf_readf_float(file, interleaved.data(), static_cast<sf_count_t>(std::min(blockFrames, remaining)));
+		if (frames > 0)
+		{
+			// Mon jel kpzse kzvetlenl a dekdolt blokkbl
+			const size_t count = static_cast<size_t>(frames);
+			remaining -= std::min(remaining, count);
+			downmixer->Process(interleaved.data(), count, mono.data());
+
+			if (decimator)
+				decimator->Process(mono.data(), count, block.Samples);
+			else
+				block.Samples.insert(block.Samples.end(), mono.begin(), mono.begin() + count);
+			return true;
+		}
+		remaining = 0;
+	}
+
+	block.SegmentEnd = true;
+	segmentOpen = false;
+	decodeSegment++;
+	return true;
+}
+
+// Vr (alszik) a kvetkez dekdolt blokkra, ill. httrszl nlkl maga dekdolja; false, ha a
+// dekdols vget rt s a sor kirlt.
+bool StreamReader::NextBlock()
+{
+	if (!decoder.joinable())
+	{
+		current.Samples.clear();
+		current.SegmentEnd = false;
+		return DecodeNext(current);
+	}
+	return filled.Pop(current);
+}
+
+size_t StreamReader::Read(float* output, const size_t count)
+{
+	size_t written = 0;
+	while (written < count && !segmentEnded)
+	{
+		if (currentPosition == current.Samples.size())
+		{
+			// Az elfogyott blokk visszakerl a kszletbe (a sorban mindig van neki hely); httrszl
+			// nlkl ugyanaz a blokk tltdik jra.
+			if (holdingBlock && decoder.joinable())
+				recycled.TryPush(current);
+
+			currentPosition = 0;
+			holdingBlock = NextBlock();
+			if (!holdingBlock)
+			{
+				segmentEnded = true;
+				break;
+			}
+
+			segmentEnded = current.SegmentEnd;
+			continue;
+		}
+
+		const size_t n = std::min(count - written, current.Samples.size() - currentPosition);
+		std::copy(current.Samples.begin() + currentPosition, current.Samples.begin() + currentPosition + n, output + written);
+		currentPosition += n;
+		written += n;
+	}
+
+	return written;
+}
+
+bool StreamReader::NextSegment()
+{
+	// Az aktulis szakasz olvasatlan blokkjainak eldobsa
+	float discard[1024];
+	while (!segmentEnded)
+		Read(discard, 1024);
+
+	if (segmentIndex + 1 >= segments.size())
+		return false;
+
+	segmentIndex++;
+	segmentEnded = false;
+	return true;
+}
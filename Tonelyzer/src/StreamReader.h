@@ -0,0 +1,85 @@
+#pragma once
+
+#include <sndfile.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include "AudioSource.h"
+#include "Decimator.h"
+#include "Downmixer.h"
+#include "SpscQueue.h"
+
+// Folyamatos dekdols kln szlon: a libsndfile-bl BlockFrames kpkocks blokkokat olvas
+// (sf_readf_float), a csatornkat rgtn monv keveri (Downmixer), igny szerint ritktja, majd
+// a blokkokat egytermels-egyfogyaszts sorban adja t az elemz szlnak; tele, ill. res sornl a
+// szlak alszanak, nem prgnek. A blokkok egy rgztett kszletbl
+// jrahasznosulnak, gy a memriaigny a fjl hossztl fggetlen, s a beolvass tfedsben fut
+// a transzformcival. Idszakaszoknl a szakaszok elejre sf_seek-kel ugrik (tmrtett
+// formtumoknl a libsndfile a keretek hatrn keres), gy a kihagyott rszek nem dekdoldnak.
+// InputSettings::BackgroundDecode == false esetn nincs dekdol szl: a Read a hv szln dekdol
+// blokkonknt (szlkszlet-feladatokhoz, ahol a prhuzamossgot a tbbi fjl adja).
+class StreamReader : public AudioSource
+{
+public:
+	static const size_t BlockFrames = 16384;
+	static const size_t BlockCount = 8;
+
+	// Sikertelen megnyitsnl std::runtime_error kivtelt dob.
+	StreamReader(const std::string& path, const InputSettings& settings = InputSettings());
+	~StreamReader() override;
+
+	StreamReader(const StreamReader&) = delete;
+	StreamReader& operator=(const StreamReader&) = delete;
+
+	size_t Read(float* output, const size_t count) override;
+	bool NextSegment() override;
+
+	inline unsigned GetSampleRate() const override { return sampleRate; }
+	inline unsigned GetChannels() const override { return channels; }
+	inline size_t GetLength() const override { return length; }
+	inline double GetSegmentStart() const override { return segments[segmentIndex].Start / static_cast<double>(sampleRate * decimationFactor); }
+
+private:
+	// Egy mon blokk, vagy (SegmentEnd esetn) egy mintk nlkli szakaszvge-jelz
+	struct Block
+	{
+		std::vector<float> Samples;
+		bool SegmentEnd = false;
+	};
+
+	void DecodeLoop();
+	bool DecodeNext(Block& block);
+	bool AcquireBlock(Block& block);
+	bool SubmitBlock(Block& block);
+	bool NextBlock();
+
+	SNDFILE* file = nullptr;
+	unsigned sampleRate = 0;
+	unsigned channels = 0;
+	size_t length = 0;
+	std::vector<Segment> segments;
+	std::unique_ptr<Decimator> decimator;
+	std::unique_ptr<Downmixer> downmixer;
+
+	SpscQueue<Block> filled;   // dekdol -> elemz
+	SpscQueue<Block> recycled; // elemz -> dekdol (res blokkok)
+	std::atomic<bool> stopping{ false };
+
+	// A dekdols llapota (a dekdol szl, ill. httrszl nlkl az elemz)
+	std::vector<float> interleaved;
+	std::vector<float> mono;
+	size_t decodeSegment = 0;
+	size_t remaining = 0; // az aktulis szakasz mg olvasatlan kpkocki
+	bool segmentOpen = false;
+
+	// Az elemz szl llapota
+	Block current;
+	bool holdingBlock = false;
+	size_t currentPosition = 0;
+	size_t segmentIndex = 0;
+	bool segmentEnded = false;
+
+	std::thread decoder;
+};
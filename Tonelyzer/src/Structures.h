@@ -1,20 +1,68 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <cstdint>
 #include <map>
 #include <sstream>
 #include <vector>
 #include <complex>
 #include <chrono>
 #include <iostream>
+#include <cmath>
 
 //Konstans PI, a komplex matekhoz
 const float PI = 3.1415927f;
 
+// A hangnemelemzsben figyelembe vett frekvenciatartomny
+const float MinAnalysisFrequency = 20.0f;
+const float MaxAnalysisFrequency = 5000.0f;
+
 enum FTmode
 {
 	FFT = 0,
-	DFT = 1
+	DFT = 1,
+	GOERTZEL = 2, // csak a hangkzppontok frekvenciit szmol Goertzel-szrbank
+	CQT = 3       // konstans Q-j transzformci ritka spektrlis kernellel
+};
+
+// Az FFT eltti ablakfggvny tpusa
+enum WindowType
+{
+	Hann = 0,
+	Hamming = 1,
+	BlackmanHarris = 2,
+	FlatTop = 3
+};
+
+// Tbbcsatorns jel monv keversnek mdja
+enum DownmixType
+{
+	Average = 0, // csatornk egyenl sllyal
+	Itu = 1,     // ITU-R BS.775: 5.1 / 7.1 esetn LFE nlkl, kzps s trhats csatornk -3 dB
+	Custom = 2   // felhasznl ltal megadott csatornnknti slyok
+};
+
+struct DownmixSettings
+{
+	DownmixType Type = DownmixType::Average;
+	std::vector<float> Weights; // csak Custom mdban
+};
+
+// Egy elemzend idszakasz msodpercben; negatv Duration esetn a fjl vgig tart.
+struct TimeRange
+{
+	double Start = 0.0;
+	double Duration = -1.0;
+};
+
+// A bemenet olvassnak belltsai
+struct InputSettings
+{
+	bool Decimate = false; // lsimt alulmintavtelezs a transzformci eltt
+	DownmixSettings Downmix;
+	std::vector<TimeRange> Ranges; // res: a teljes fjl
+	bool BackgroundDecode = true; // StreamReader: dekdols kln szlon (false: a hv szln)
 };
 
 struct AudioData
@@ -23,50 +71,398 @@ struct AudioData
 	unsigned SampleRate = 0;
 	unsigned Channels = 0;
 	float referencePitch = 440.0f;
-	std::vector<float> ReaderData;
 	std::vector<float> MonoData;
 	std::string Filename;
 };
 
+// l bemenet nyers PCM mintaformtuma (little-endian)
+enum PcmFormat
+{
+	S16 = 0,
+	S32 = 1,
+	F32 = 2
+};
+
+// l bemenet (-live): nyers, tlapolt PCM jel a szabvnyos bemenetrl vagy egy csbl
+struct LiveSettings
+{
+	bool Enabled = false;
+	PcmFormat Format = PcmFormat::S16;
+	unsigned SampleRate = 44100;
+	unsigned Channels = 2;
+	double Decay = 8.0; // a felejt hangosztly-hisztogram idllandja msodpercben; 0: nincs felejts
+};
+
+// Hangnemprofil-csald kivlasztsa az egyttes dntshez megadott sllyal
+struct ProfileSelection
+{
+	std::string Name;
+	float Weight = 1.0f;
+};
+
 struct InitData
 {
 	FTmode   FourierMode = FTmode::FFT;
 	float    ReferencePitch = 440.0f;
+	bool     EstimateTuning = false; // -f=auto: a referencia-hangmagassg becslse a spektrumbl
 	unsigned FTWindowSize = 16384;
+	unsigned ThreadCount = 0; // 0: a hardver ltal tmogatott szlak szma
+	WindowType Window = WindowType::Hann;
+	unsigned BinsPerSemitone = 1; // CQT mdban 1 vagy 3
+	InputSettings Input;
+	std::vector<ProfileSelection> Profiles; // res: csak Krumhansl-Kessler
+	double TrackSpan = 0.0; // idbeli hangnemkvets cssz ablaknak hossza msodpercben; 0: kikapcsolva
+	std::string ChromaPath; // ablakonknti kromagram kimeneti fjlja (.npy); res: nincs kirs
+	bool ChromaHalf = false; // float16 kromagram float32 helyett
+	std::vector<std::string> Inputs; // a nem kapcsol argumentumok: fjlok, knyvtrak, @listafjlok
+	std::string CachePath; // tarts eredmny-gyorsttr fjlja; res: nincs gyorsttr
+	bool SpectrumSidecar = false; // az tlagolt spektrum trolsa / jrahasznlsa spektrumfjlban
+	std::string SidecarDirectory; // a spektrumfjlok knyvtra; res: a hangfjl mellett
+	std::string ServePath; // kiszolgl md socketjnek tvonala; res: egyszeri futs
+	LiveSettings Live;
 };
 
 // A programban hasznlt alias elnevezsek
 using FTdata = std::vector<std::complex<float>>;
 using PitchHistogram = std::array<float, 12>;
+// Flhangonknt FineChromaResolution osztly hangosztly-vektor: az i. osztly kzepe i / FineChromaResolution
+// flhanggal van a C fltt (a referencia-hangmagassghoz mrve). A hangols becslse utni forgatshoz.
+const unsigned FineChromaResolution = 5;
+using FineChroma = std::array<float, 12 * FineChromaResolution>;
 using PitchNames = std::array<std::string, 12>;
 using KeyPair = std::pair<int, int>;
 
+// Egy profilcsald (vagy az egyttes dnts) legjobb hangneme s annak korrelcija
+struct KeyEstimate
+{
+	std::string Profile;
+	KeyPair Key = KeyPair(0, 1);
+	float Score = 0.0f;
+};
+
+struct KeyAnalysis
+{
+	std::vector<KeyEstimate> Families;
+	KeyEstimate Ensemble; // a csaldok korrelciinak slyozott tlagbl
+};
+
+// Egy fjl elemzsnek eredmnye
+struct FileResult
+{
+	std::string Path;
+	float ReferencePitch = 440.0f; // -f=auto esetn a becslt rtk
+	PitchHistogram Histogram;
+	KeyAnalysis Keys;
+};
+
+// Egyetlen ablak hangosztly-vektora s az ablak kezdete a fjlban (msodperc)
+struct ChromaFrame
+{
+	double Time = 0.0;
+	PitchHistogram Chroma;
+};
+
+// Egyetlen ablak finom felbonts hangosztly-vektora (ChromaMap::Rotate forgatja 12 osztlyra)
+struct FineChromaFrame
+{
+	double Time = 0.0;
+	FineChroma Chroma;
+};
+
+// Idbeli hangnemkvets: a cssz ablak kzephez tartoz becsls, ill. az azonos hangnem
+// egymst kvet becslsekbl sszevont szakasz (a Start egyben vltsi pont)
+struct KeyFrame
+{
+	double Time = 0.0;
+	KeyEstimate Estimate;
+};
+
+struct KeyRegion
+{
+	double Start = 0.0;
+	double End = 0.0;
+	KeyPair Key = KeyPair(0, 1);
+	float Score = 0.0f; // a szakasz becslseinek tlagos korrelcija
+};
+
+// Az tlagolt spektrum s a bin-ek rtelmezshez szksges adatok.
+// FFT/DFT mdban a Bins a vals jel fl-spektruma (WindowSize/2+1 bin), hangkzpont mdokban
+// (GOERTZEL, CQT) pedig hangonknt BinsPerSemitone bin, a FirstMidi hangtl felfel.
+struct Spectrum
+{
+	FTmode Mode = FTmode::FFT;
+	FTdata Bins;
+	unsigned SampleRate = 0;
+	unsigned WindowSize = 0;
+	float ReferencePitch = 440.0f;
+	int FirstMidi = 0;
+	unsigned BinsPerSemitone = 1;
+	std::vector<float> Magnitudes; // az ablakonknti amplitdspektrumok tlaga (csak ha krtk, FFT/DFT mdban)
+};
+
+// Egy tlagolt spektrum nem birtokl nzete: egy Spectrum vektoraira vagy egy memriba kpezett
+// spektrumfjl (SpectrumSidecar) adataira mutat. Mezi a Spectrum azonos nev mezinek felelnek meg.
+struct SpectrumView
+{
+	FTmode Mode = FTmode::FFT;
+	const std::complex<float>* Bins = nullptr;
+	size_t BinCount = 0;
+	unsigned SampleRate = 0;
+	unsigned WindowSize = 0;
+	float ReferencePitch = 440.0f;
+	int FirstMidi = 0;
+	unsigned BinsPerSemitone = 1;
+	const float* Magnitudes = nullptr;
+	size_t MagnitudeCount = 0;
+};
+
+inline SpectrumView GetSpectrumView(const Spectrum& spectrum)
+{
+	SpectrumView view;
+	view.Mode = spectrum.Mode;
+	view.Bins = spectrum.Bins.data();
+	view.BinCount = spectrum.Bins.size();
+	view.SampleRate = spectrum.SampleRate;
+	view.WindowSize = spectrum.WindowSize;
+	view.ReferencePitch = spectrum.ReferencePitch;
+	view.FirstMidi = spectrum.FirstMidi;
+	view.BinsPerSemitone = spectrum.BinsPerSemitone;
+	view.Magnitudes = spectrum.Magnitudes.data();
+	view.MagnitudeCount = spectrum.Magnitudes.size();
+	return view;
+}
+
+// Sztvlasztott (SoA) komplex puffer: kln vals s kpzetes tmb a SIMD-es FFT-hez.
+struct SplitFTdata
+{
+	std::vector<float> Re;
+	std::vector<float> Im;
+};
+
+inline const char* GetFTmodeName(const FTmode mode)
+{
+	switch (mode)
+	{
+	case FTmode::DFT:      return "DFT";
+	case FTmode::GOERTZEL: return "Goertzel";
+	case FTmode::CQT:      return "CQT";
+	default:               return "FFT";
+	}
+}
+
+// 64 bites FNV-1a hash (a gyorsttrak kulcsaihoz); a hash paramterrel lncolhat.
+inline uint64_t HashBytes(const void* data, const size_t size, uint64_t hash = 14695981039346656037ull)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+// MIDI hangszm <-> frekvencia tvlts a megadott A4 (69-es MIDI hang) hangmagassghoz
+inline float FrequencyToMidi(const float frequency, const float referencePitch)
+{
+	return 69.0f + 12.0f * std::log2(frequency / referencePitch);
+}
+
+inline float MidiToFrequency(const float midi, const float referencePitch)
+{
+	return referencePitch * std::pow(2.0f, (midi - 69.0f) / 12.0f);
+}
+
+// A MinAnalysisFrequency s MaxAnalysisFrequency (legfeljebb a Nyquist-frekvencia) kz es
+// els s utols MIDI hang
+inline std::pair<int, int> GetAnalysisNoteRange(const float referencePitch, const unsigned sampleRate)
+{
+	const float maxFrequency = std::min(MaxAnalysisFrequency, sampleRate / 2.0f);
+	const int firstMidi = static_cast<int>(std::ceil(FrequencyToMidi(MinAnalysisFrequency, referencePitch)));
+	const int lastMidi = static_cast<int>(std::floor(FrequencyToMidi(maxFrequency, referencePitch)));
+	return std::make_pair(firstMidi, lastMidi);
+}
+
+// Egy "-kapcsol=rtk" alak parancssori argumentum rtkrsze
+inline std::string GetFlagValue(const std::string& flag)
+{
+	std::string value;
+	std::istringstream str(flag);
+	std::getline(str, value, '=');
+	std::getline(str, value, '=');
+	return value;
+}
+
+// Idpont msodpercben: "90", "1:30" vagy "1:02:30" alakban
+inline double ParseTime(const std::string& text)
+{
+	double seconds = 0.0;
+	std::string part;
+	std::istringstream str(text);
+	while (std::getline(str, part, ':'))
+		seconds = seconds * 60.0 + std::atof(part.c_str());
+	return seconds;
+}
+
+// Profilcsald-lista: "nev[:suly],nev[:suly],..." (a nevek ellenrzse a PitchAnalyzer feladata)
+inline std::vector<ProfileSelection> ParseProfiles(const std::string& list)
+{
+	std::vector<ProfileSelection> profiles;
+	std::string entry;
+	std::istringstream entries(list);
+	while (std::getline(entries, entry, ','))
+	{
+		ProfileSelection selection;
+		const size_t separator = entry.find(':');
+		selection.Name = entry.substr(0, separator);
+		if (separator != std::string::npos)
+			selection.Weight = static_cast<float>(std::atof(entry.substr(separator + 1).c_str()));
+		profiles.push_back(selection);
+	}
+	return profiles;
+}
+
 inline InitData GetInitData(int argc, char* argv[])
 {
 	InitData data;
+	TimeRange selection; // -start / -duration
+	bool hasSelection = false;
 	for (int i = 0; i < argc; i++)
 	{
 		std::string cur = std::string(argv[i]);
 
+		if (i > 0 && !cur.empty() && cur[0] != '-') // Bemeneti fjl, knyvtr vagy @listafjl
+		{
+			data.Inputs.push_back(cur);
+			continue;
+		}
+
 		if (cur == "-dft") // DFT flag figyel
 			data.FourierMode = FTmode::DFT;
-		else if (cur.substr(0, 2) == "-f") // ReferencePitch-flag figyel
+		else if (cur == "-goertzel") // Goertzel-szrbank flag figyel
+			data.FourierMode = FTmode::GOERTZEL;
+		else if (cur == "-cqt") // CQT flag figyel
+			data.FourierMode = FTmode::CQT;
+		else if (cur == "-decimate") // Alulmintavtelezs flag figyel (a "-dft"-vel nem tkzik, pontos egyezs)
+			data.Input.Decimate = true;
+		else if (cur.substr(0, 4) == "-bps") // Flhangonknti CQT bin-szm flag figyel
 		{
-			std::string freq_str;
-			std::istringstream str(cur);
-			std::getline(str, freq_str, '=');
-			std::getline(str, freq_str, '=');
-			data.ReferencePitch = static_cast<float>(std::atoi(freq_str.c_str()));
+			data.BinsPerSemitone = static_cast<unsigned>(std::atoi(GetFlagValue(cur).c_str()));
+			if (data.BinsPerSemitone != 1 && data.BinsPerSemitone != 3)
+			{
+				std::cerr << "CQT bins per semitone must be 1 or 3, using 1." << std::endl;
+				data.BinsPerSemitone = 1;
+			}
 		}
-		else if (cur.substr(0, 2) == "-w") // Window-flag figyel
+		else if (cur.substr(0, 4) == "-mix") // Lekevers flag figyel: avg, itu vagy vesszvel elvlasztott slyok
+		{
+			const std::string mix = GetFlagValue(cur);
+			if (mix == "avg")
+				data.Input.Downmix.Type = DownmixType::Average;
+			else if (mix == "itu")
+				data.Input.Downmix.Type = DownmixType::Itu;
+			else
+			{
+				std::string weight;
+				std::istringstream weights(mix);
+				data.Input.Downmix.Type = DownmixType::Custom;
+				while (std::getline(weights, weight, ','))
+					data.Input.Downmix.Weights.push_back(static_cast<float>(std::atof(weight.c_str())));
+			}
+		}
+		else if (cur.substr(0, 6) == "-start") // Kezdidpont flag figyel
+		{
+			selection.Start = ParseTime(GetFlagValue(cur));
+			hasSelection = true;
+		}
+		else if (cur.substr(0, 9) == "-duration") // Idtartam flag figyel
+		{
+			selection.Duration = ParseTime(GetFlagValue(cur));
+			hasSelection = true;
+		}
+		else if (cur.substr(0, 6) == "-range") // Idszakasz flag figyel: kezdet-vg, a vg elhagyhat (tbbszr is megadhat)
+		{
+			const std::string value = GetFlagValue(cur);
+			const size_t separator = value.find('-');
+			TimeRange range;
+			range.Start = ParseTime(value.substr(0, separator));
+			if (separator != std::string::npos && separator + 1 < value.size())
+				range.Duration = std::max(0.0, ParseTime(value.substr(separator + 1)) - range.Start);
+			data.Input.Ranges.push_back(range);
+		}
+		else if (cur.substr(0, 9) == "-profiles") // Profilcsald flag figyel: nev[:suly],nev[:suly],... vagy all
+		{
+			const std::vector<ProfileSelection> profiles = ParseProfiles(GetFlagValue(cur));
+			data.Profiles.insert(data.Profiles.end(), profiles.begin(), profiles.end());
+		}
+		else if (cur.substr(0, 9) == "-chroma16") // Kromagram-kirs flag figyel, float16 rtkekkel (a "-chroma" eltt kell vizsglni!)
+		{
+			data.ChromaPath = GetFlagValue(cur);
+			data.ChromaHalf = true;
+		}
+		else if (cur.substr(0, 7) == "-chroma") // Kromagram-kirs flag figyel, float32 rtkekkel
+			data.ChromaPath = GetFlagValue(cur);
+		else if (cur.substr(0, 6) == "-cache") // Eredmny-gyorsttr flag figyel
+			data.CachePath = GetFlagValue(cur);
+		else if (cur.substr(0, 8) == "-sidecar") // Spektrumfjl flag figyel: "-sidecar" vagy "-sidecar=knyvtr"
+		{
+			data.SpectrumSidecar = true;
+			if (cur.find('=') != std::string::npos)
+				data.SidecarDirectory = GetFlagValue(cur);
+		}
+		else if (cur.substr(0, 6) == "-serve") // Kiszolgl md flag figyel: a socket tvonala
+			data.ServePath = GetFlagValue(cur);
+		else if (cur.substr(0, 5) == "-live") // l bemenet flag figyel: "-live" vagy "-live=s16|s32|f32"
 		{
-			std::string wins_str;
-			std::istringstream str(cur);
-			std::getline(str, wins_str, '=');
-			std::getline(str, wins_str, '=');
-			data.FTWindowSize = static_cast<unsigned>(std::atoi(wins_str.c_str()));
+			data.Live.Enabled = true;
+			const std::string format = cur.find('=') != std::string::npos ? GetFlagValue(cur) : "s16";
+			if (format == "s16")
+				data.Live.Format = PcmFormat::S16;
+			else if (format == "s32")
+				data.Live.Format = PcmFormat::S32;
+			else if (format == "f32")
+				data.Live.Format = PcmFormat::F32;
+			else
+				std::cerr << "Unknown PCM format '" << format << "', using s16." << std::endl;
 		}
+		else if (cur.substr(0, 5) == "-rate") // l bemenet mintavteli frekvencia flag figyel
+			data.Live.SampleRate = static_cast<unsigned>(std::atoi(GetFlagValue(cur).c_str()));
+		else if (cur.substr(0, 9) == "-channels") // l bemenet csatornaszm flag figyel
+			data.Live.Channels = static_cast<unsigned>(std::atoi(GetFlagValue(cur).c_str()));
+		else if (cur.substr(0, 6) == "-decay") // l hisztogram idlland flag figyel (msodperc)
+			data.Live.Decay = std::atof(GetFlagValue(cur).c_str());
+		else if (cur.substr(0, 6) == "-track") // Hangnemkvets flag figyel: a cssz ablak hossza ("10" vagy "0:10")
+			data.TrackSpan = ParseTime(GetFlagValue(cur));
+		else if (cur.substr(0, 2) == "-f") // ReferencePitch-flag figyel ("auto": hangolsbecsls)
+		{
+			const std::string pitch = GetFlagValue(cur);
+			if (pitch == "auto")
+				data.EstimateTuning = true;
+			else
+				data.ReferencePitch = static_cast<float>(std::atoi(pitch.c_str()));
+		}
+		else if (cur.substr(0, 4) == "-win") // Ablakfggvny-flag figyel (a "-w" eltt kell vizsglni!)
+		{
+			const std::string window = GetFlagValue(cur);
+			if (window == "hann")
+				data.Window = WindowType::Hann;
+			else if (window == "hamming")
+				data.Window = WindowType::Hamming;
+			else if (window == "blackmanharris")
+				data.Window = WindowType::BlackmanHarris;
+			else if (window == "flattop")
+				data.Window = WindowType::FlatTop;
+			else
+				std::cerr << "Unknown window function '" << window << "', using Hann." << std::endl;
+		}
+		else if (cur.substr(0, 2) == "-w") // Window-flag figyel
+			data.FTWindowSize = static_cast<unsigned>(std::atoi(GetFlagValue(cur).c_str()));
+		else if (cur.substr(0, 2) == "-j") // Szlszm-flag figyel
+			data.ThreadCount = static_cast<unsigned>(std::atoi(GetFlagValue(cur).c_str()));
 	}
 
+	if (hasSelection)
+		data.Input.Ranges.insert(data.Input.Ranges.begin(), selection);
+
 	return data;
 }
\ No newline at end of file
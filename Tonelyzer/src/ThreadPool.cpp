@@ -0,0 +1,249 @@
+#include <algorithm>
+#include <exception>
+#include <memory>
+
+#include "ThreadPool.h"
+
+// Az aktulis szl melyik kszlet hnyadik sorhoz tartozik (kls szlaknl a kzs, 0. sor).
+static thread_local const ThreadPool* currentPool = nullptr;
+static thread_local size_t currentIndex = 0;
+
+ThreadPool::ThreadPool(const unsigned threadCount)
+{
+	const unsigned count = threadCount == 0 ? GetDefaultThreadCount() : threadCount;
+	for (unsigned i = 0; i < count; i++)
+		queues.emplace_back(new TaskQueue());
+
+	for (unsigned i = 1; i < count; i++)
+		workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		stopping = true;
+	}
+	available.notify_all();
+
+	for (std::thread& worker : workers)
+		worker.join();
+}
+
+size_t ThreadPool::GetQueueIndex() const
+{
+	return currentPool == this ? currentIndex : 0;
+}
+
+void ThreadPool::Notify(const bool all)
+{
+	// A zr megszerzse utn rtestnk, gy a prediktumot pp vizsgl szl nem marad le rla.
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+	}
+	if (all)
+		available.notify_all();
+	else
+		available.notify_one();
+}
+
+void ThreadPool::Push(Task task)
+{
+	TaskQueue& queue = *queues[GetQueueIndex()];
+	{
+		std::lock_guard<std::mutex> lock(queue.Mutex);
+		queue.Tasks.push_back(std::move(task));
+	}
+	queued++;
+}
+
+bool ThreadPool::Pop(const size_t index, const bool back, Task& task)
+{
+	TaskQueue& queue = *queues[index];
+	std::lock_guard<std::mutex> lock(queue.Mutex);
+	if (queue.Tasks.empty())
+		return false;
+
+	if (back)
+	{
+		task = std::move(queue.Tasks.back());
+		queue.Tasks.pop_back();
+	}
+	else
+	{
+		task = std::move(queue.Tasks.front());
+		queue.Tasks.pop_front();
+	}
+	queued--;
+	return true;
+}
+
+// Sajt sor (munkaszlnl a vge, a kzs sornl az eleje), majd lops a tbbi munkaszl sornak
+// elejrl, vgl a kzs sorbl.
+bool ThreadPool::TryRunTask(const size_t index)
+{
+	Task task;
+	bool found = Pop(index, index != 0, task);
+
+	const size_t workerQueues = queues.size() - 1;
+	for (size_t k = 1; k <= workerQueues && !found; k++)
+	{
+		const size_t victim = 1 + (index + k - 1) % workerQueues;
+		if (victim != index)
+			found = Pop(victim, false, task);
+	}
+
+	if (!found && index != 0)
+		found = Pop(0, false, task);
+
+	if (found)
+		task.Run();
+	return found;
+}
+
+// A hv sornak vgrl eltvoltja az owner ltal betett, senki ltal t nem vett feladatokat.
+void ThreadPool::RemoveOwned(const void* owner)
+{
+	TaskQueue& queue = *queues[GetQueueIndex()];
+	std::lock_guard<std::mutex> lock(queue.Mutex);
+	while (!queue.Tasks.empty() && queue.Tasks.back().Owner == owner)
+	{
+		queue.Tasks.pop_back();
+		queued--;
+	}
+}
+
+void ThreadPool::ParallelFor(const size_t count, const std::function<void(size_t)>& body)
+{
+	if (count == 0)
+		return;
+
+	struct LoopState
+	{
+		std::atomic<size_t> next{ 0 };
+		std::atomic<size_t> done{ 0 };
+		std::mutex mutex;
+		std::condition_variable finished;
+		std::exception_ptr error;
+	};
+	std::shared_ptr<LoopState> state = std::make_shared<LoopState>();
+
+	// A segt szlak csak akkor nylnak a trzshz, ha mg van feldolgozatlan index,
+	// gy a hv visszatrse utn indul segt sem hasznlja a (mr rvnytelen) referencit.
+	auto run = [state, count, &body]()
+	{
+		size_t i;
+		while ((i = state->next++) < count)
+		{
+			try
+			{
+				body(i);
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock(state->mutex);
+				if (!state->error)
+					state->error = std::current_exception();
+			}
+
+			if (++state->done == count)
+			{
+				std::lock_guard<std::mutex> lock(state->mutex);
+				state->finished.notify_all();
+			}
+		}
+	};
+
+	const size_t helpers = std::min(workers.size(), count - 1);
+	if (helpers > 0)
+	{
+		for (size_t i = 0; i < helpers; i++)
+		{
+			Task task;
+			task.Run = run;
+			task.Owner = state.get();
+			Push(std::move(task));
+		}
+		Notify(true);
+	}
+
+	run();
+	if (helpers > 0)
+		RemoveOwned(state.get());
+
+	std::unique_lock<std::mutex> lock(state->mutex);
+	state->finished.wait(lock, [&]() { return state->done == count; });
+
+	if (state->error)
+		std::rethrow_exception(state->error);
+}
+
+void ThreadPool::Submit(std::function<void()> task)
+{
+	pending++;
+
+	Task wrapped;
+	wrapped.Run = [this, task]()
+	{
+		try
+		{
+			task();
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock(errorMutex);
+			if (!submitError)
+				submitError = std::current_exception();
+		}
+
+		if (--pending == 0)
+			Notify(true);
+	};
+	Push(std::move(wrapped));
+	Notify(false);
+}
+
+void ThreadPool::Wait()
+{
+	const size_t index = GetQueueIndex();
+	while (pending > 0)
+	{
+		if (TryRunTask(index))
+			continue;
+
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		available.wait(lock, [this]() { return pending == 0 || queued > 0; });
+	}
+
+	std::lock_guard<std::mutex> lock(errorMutex);
+	if (submitError)
+	{
+		std::exception_ptr error = submitError;
+		submitError = nullptr;
+		std::rethrow_exception(error);
+	}
+}
+
+unsigned ThreadPool::GetDefaultThreadCount()
+{
+	const unsigned hardware = std::thread::hardware_concurrency();
+	return hardware == 0 ? 1 : hardware;
+}
+
+void ThreadPool::WorkerLoop(const size_t index)
+{
+	currentPool = this;
+	currentIndex = index;
+
+	for (;;)
+	{
+		if (TryRunTask(index))
+			continue;
+
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		available.wait(lock, [this]() { return stopping || queued > 0; });
+
+		if (stopping && queued == 0)
+			return;
+	}
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fix szlszm, munkalop feladatkszlet.
+// Minden munkaszlnak sajt feladatsora van: a sajt sorbl a legutbb betett feladatot veszi ki,
+// resjratban pedig a tbbi szl sornak elejrl lop. A kszleten kvli szlak (pl. a fszl)
+// feladatai egy kzs sorba kerlnek, ezt a munkaszlak csak a sajt soraik utn nzik meg.
+// gy egy nagy fjl ParallelFor-csomagjait a szabad szlak tveszik, mieltt j fjlba kezdennek.
+// A ParallelFor s a Wait hv szla maga is dolgozik, ezrt n szlas kszlethez n-1 httrszl tartozik.
+class ThreadPool
+{
+public:
+	// 0 szlszm esetn a hardver ltal tmogatott szlak szmt hasznlja.
+	explicit ThreadPool(const unsigned threadCount = 0);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// A [0, count) indexekre lefuttatja a trzset, s megvrja, amg mind elkszl.
+	// A trzsben dobott els kivtelt a hv szlon dobja tovbb. Munkaszlrl is hvhat.
+	void ParallelFor(const size_t count, const std::function<void(size_t)>& body);
+
+	// nll feladat bekldse (pl. egy fjl teljes elemzse); a Wait vrja meg.
+	void Submit(std::function<void()> task);
+
+	// Megvrja az sszes bekldtt feladatot, kzben a hv szl is feladatokat futtat.
+	// A feladatokban dobott els kivtelt tovbbdobja.
+	void Wait();
+
+	inline unsigned GetThreadCount() const { return static_cast<unsigned>(workers.size()) + 1; }
+
+	static unsigned GetDefaultThreadCount();
+
+private:
+	struct Task
+	{
+		std::function<void()> Run;
+		const void* Owner = nullptr; // a feladatot betev ParallelFor hvs (a fel nem hasznltak eltvoltshoz)
+	};
+
+	struct TaskQueue
+	{
+		std::mutex Mutex;
+		std::deque<Task> Tasks;
+	};
+
+	void WorkerLoop(const size_t index);
+	size_t GetQueueIndex() const;
+	void Push(Task task);
+	bool Pop(const size_t index, const bool back, Task& task);
+	bool TryRunTask(const size_t index);
+	void RemoveOwned(const void* owner);
+	void Notify(const bool all);
+
+	std::vector<std::thread> workers;
+	std::vector<std::unique_ptr<TaskQueue>> queues; // 0: kzs sor a kls szlaknak, i: az i. munkaszl sora
+	std::atomic<size_t> queued{ 0 };  // a sorokban lv feladatok szma
+	std::atomic<size_t> pending{ 0 }; // bekldtt (Submit), mg be nem fejezett feladatok
+	std::mutex sleepMutex;
+	std::condition_variable available;
+	bool stopping = false;
+
+	std::mutex errorMutex;
+	std::exception_ptr submitError;
+};
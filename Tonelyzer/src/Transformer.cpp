@@ -1,7 +1,11 @@
+#include <limits>
+
 #include "Transformer.h"
+#include "ChromaMap.h"
+#include "OctavePyramid.h"
 
-Transformer::Transformer(const AudioData& audioData, const unsigned windowSize)
-	: data(audioData)
+Transformer::Transformer(AudioSource& audioSource, const unsigned windowSize)
+	: source(audioSource)
 {
 	try 
 	{
@@ -42,102 +46,433 @@ void Transformer::DFT(const FTdata& window, FTdata& result) const
 	}
 }
 
-// Rekurzv Cooley-Tukey fle Gyors Fourier-transzformci (FFT) meghatrozott mret ablakra.
+// Cooley-Tukey fle Gyors Fourier-transzformci (FFT) meghatrozott mret ablakra.
 // Szmtsi bonyolultsga: O(n*log2(n)). Sokkal gyorsabb, s nagyobb ablakmreteket is elbr!
+// A tnyleges szmtst az ablakmrethez tartoz, elre felptett FFTPlan vgzi.
 void Transformer::FFT(const FTdata& window, FTdata& result) const
 {
-	if (window.size() <= 1)
+	if (plan && plan->GetSize() == window.size())
+		plan->Forward(window, result);
+	else
+		FFTPlan::Get(window.size())->Forward(window, result);
+}
+
+// Generikus Fourier-transzformci rutin. FFT/DFT mdban az tlagolt spektrum windowSize/2+1 elem
+// (0 Hz - Nyquist), GOERTZEL mdban hangonknt, CQT mdban flhangonknt binsPerSemitone darab
+// tlagolt amplitdt tartalmaz.
+// A jelet a forrsbl folyamatosan olvassuk egy BatchWindows ablaknyi cssz pufferbe, gy a
+// memriaigny a fjl hossztl fggetlen. Tbb idszakasz esetn az ablakok nem lgnak t a
+// szakaszhatrokon: egy szakasz vgn a maradk (ablaknl rvidebb) mintk elvesznek. Egy kteg ablakai rgztett mret csomagokra vannak
+// osztva; a csomagokat a szlkszlet prhuzamosan dolgozza fel, mindegyik sajt rszsszegbe gyjt.
+// A rszsszegek rgztett sorrend, pronknti sszevonsa, majd a ktegsszegek sorrendben val
+// sszeadsa miatt az eredmny bitre azonos, brmennyi szlon fut.
+// Belltott FrameCallback esetn minden ablak amplitdspektruma hangosztlyokba is sszegzdik; a kteg
+// ablakainak vektorai a kteg vgn, idrendben kerlnek tadsra.
+// SetMagnitudeAverage esetn FFT/DFT mdban ugyanebben a menetben az ablakok amplitdspektrumai is
+// tlagoldnak (a komplex tlagban az ablakonknt forg fzisok miatt a cscsok elmosdhatnak).
+Spectrum Transformer::AvgFourier(FTmode mode) const
+{
+	if (verbose)
 	{
-		result = window;
-		return;
-	};
+		std::cout << "Tonelyzer: Processing " << source.GetFilename() << " in " << GetFTmodeName(mode) << " mode";
+		std::cout << " with " << WindowFunction::GetName(windowType) << " window";
+		std::cout << " on " << (pool ? pool->GetThreadCount() : 1) << " thread(s). " << std::endl;
+		std::cout << "--------------------------------" << std::endl;
+	}
 
-	const size_t halfSize = window.size() / 2;
+	const float overlapFactor = 0.5f;
+	const size_t hop = GetHopSize();
 
-	FTdata even(halfSize), odd(halfSize);
-	for (size_t i = 0; i < halfSize; i++) 
+	// CQT mdban a beolvasott mintk az oktvonknt ritktott jelpiramisba is bekerlnek, a svok keretei
+	// onnan jnnek. A puffer a ritkts miatt az ablaknl hosszabb keretet fog t (CQTKernel), a lpskz
+	// marad. A szakaszok kt vgn pad nulla minta ll, gy minden keret kzppontja s a keretek szma a
+	// windowSize mret ablakokval egyezik. A mly svok csak minden Stride. ablakban futnak; az tlagban
+	// a sv kirtkelseinek tlaga szerepel, az ablakonknti vektorokban a legutbbi eredmnye.
+	std::shared_ptr<const CQTKernel> cqt;
+	std::unique_ptr<OctavePyramid> pyramid;
+	size_t frameSize = windowSize;
+	if (mode == FTmode::CQT)
 	{
-		even[i] = window[i * 2];
-		odd[i]  = window[i * 2 + 1];
+		cqt = CQTKernel::Get(source.GetSampleRate(), windowSize, referencePitch, binsPerSemitone, windowType);
+		pyramid.reset(new OctavePyramid(cqt->GetLevelCount()));
+		frameSize = cqt->GetFrameSize();
 	}
 
-	// Rekurzv FFT-ablakok futtatsa
-	FTdata trEven(halfSize), trOdd(halfSize);
-	FFT(even, trEven);
-	FFT(odd, trOdd);
+	// A csomag- s ktegmret rgztett, nem fgg a szlak szmtl.
+	const size_t windowsPerChunk = 4;
+	const size_t chunksPerBatch = 16;
+	const size_t batchWindows = windowsPerChunk * chunksPerBatch;
+	const size_t batchSpan = (batchWindows - 1) * hop + frameSize;
 
-	result.resize(window.size());
-	for (size_t k = 0; k < halfSize; k++) 
+	// Csak a becslt futsid kijelzshez
+	const size_t expectedRuns = source.GetLength() > windowSize ? (source.GetLength() - windowSize) / hop + 1 : 0;
+
+	Spectrum spectrum;
+	spectrum.Mode = mode;
+	spectrum.SampleRate = source.GetSampleRate();
+	spectrum.WindowSize = windowSize;
+	spectrum.ReferencePitch = referencePitch;
+
+	// Vals bemenetnl csak az els n/2+1 bin egyedi, a tbbi ezek konjugltja.
+	size_t spectrumSize = windowSize / 2 + 1;
+
+	std::shared_ptr<const GoertzelBank> bank;
+	if (mode == FTmode::GOERTZEL)
 	{
-		std::complex<float> t = std::polar(1.0f, -2.0f * PI * k / window.size()) * trOdd[k];
-		result[k]			  = trEven[k] + t;
-		result[k + halfSize]  = trEven[k] - t;
+		bank = GoertzelBank::Get(spectrum.SampleRate, windowSize, referencePitch, windowType);
+		spectrumSize = bank->GetNoteCount();
+		spectrum.FirstMidi = bank->GetFirstMidi();
 	}
-}
 
-// Generikus Fourier-transzformci rutin.
-FTdata Transformer::AvgFourier(FTmode mode) const
-{
-	std::cout << "Tonelyzer: Processing " << data.Filename << " in " << (mode == FTmode::DFT ? "DFT" : "FFT") << " mode. " << std::endl;	
-	std::cout << "--------------------------------" << std::endl;
+	if (cqt)
+	{
+		spectrumSize = cqt->GetBinCount();
+		spectrum.FirstMidi = cqt->GetFirstMidi();
+		spectrum.BinsPerSemitone = cqt->GetBinsPerSemitone();
+	}
 
-	const float overlapFactor = 0.5f;
+	// Ablakonknti hangosztly-vektorok (csak FrameCallback esetn)
+	std::shared_ptr<const ChromaMap> chromaMap;
+	const bool fineFrames = fineFrameCallback && (mode == FTmode::FFT || mode == FTmode::DFT);
+	if ((frameCallback || fineFrames) && (mode == FTmode::FFT || mode == FTmode::DFT))
+		chromaMap = ChromaMap::Get(spectrum.SampleRate, windowSize, referencePitch);
+	std::vector<ChromaFrame> frames(frameCallback ? batchWindows : 0);
+	std::vector<FineChromaFrame> fines(fineFrames ? batchWindows : 0);
+	std::vector<FTdata> bandFrames(frameCallback && cqt ? batchWindows : 0, FTdata(spectrumSize));
+	FTdata heldBands(frameCallback && cqt ? spectrumSize : 0);
+	std::vector<size_t> bandRuns(cqt ? cqt->GetBandCount() : 0, 0); // svonknt a kirtkelt ablakok
+
+	std::vector<FTdata> partials(chunksPerBatch, FTdata(spectrumSize, 0.0f));
+	FTdata total(spectrumSize, 0.0f);
+
+	const bool magnitudes = magnitudeAverage && (mode == FTmode::FFT || mode == FTmode::DFT);
+	std::vector<std::vector<float>> magnitudePartials(magnitudes ? chunksPerBatch : 0, std::vector<float>(spectrumSize, 0.0f));
+	std::vector<float> magnitudeTotal(magnitudes ? spectrumSize : 0, 0.0f);
+	const size_t pad = (frameSize - windowSize) / 2;
+	std::vector<float> buffer(batchSpan + pad, 0.0f);
+
+	// Elre kiszmolt ablakfggvny-tbla
+	const std::shared_ptr<const std::vector<float>> weightTable = WindowFunction::Get(windowType, windowSize);
+	const float* weights = weightTable->data();
+
+	auto before = std::chrono::high_resolution_clock::now(); // Idmrs
 	size_t runs = 0;
-	float runtime = 0.0f;
-	size_t totalRuns = static_cast<size_t>(std::floor(data.MonoData.size() / (windowSize * overlapFactor)));
+	size_t totalSamples = 0;
+	size_t available = pad; // a szakasz eleji nullk (a puffer nullzva indul)
+	bool tailPadded = false;
+	size_t batchRuns = 0;
+	size_t segmentRuns = 0;
+	double segmentStart = source.GetSegmentStart();
+	bool endOfStream = false;
+	bool estimatePrinted = false;
+	if (pyramid)
+		pyramid->Append(buffer.data(), pad);
 
-	FTdata out(windowSize, 0.0f);
+	auto processChunk = [&](size_t chunk)
+	{
+		// Munkapufferek csomagonknt egyszer - ablakonknt nincs memriafoglals.
+		// (CQT mdban a svkeretek spektrumt a RealFFTPlan::Forward mretezi.)
+		FTdata window(mode == FTmode::DFT ? windowSize : 0);
+		FTdata result(mode == FTmode::DFT ? windowSize : spectrumSize);
+		FTdata& partial = partials[chunk];
+		std::fill(partial.begin(), partial.end(), std::complex<float>(0.0f, 0.0f));
+		if (magnitudes)
+			std::fill(magnitudePartials[chunk].begin(), magnitudePartials[chunk].end(), 0.0f);
 
-	for (size_t i = 0; i + windowSize < data.MonoData.size(); i += static_cast<size_t>(overlapFactor * windowSize), runs++)
+		const size_t first = chunk * windowsPerChunk;
+		const size_t last = std::min(batchRuns, first + windowsPerChunk);
+		for (size_t run = first; run < last; run++)
+		{
+			// Jelenlegi ablak: az ablakfggvnnyel val szorzs az FFT bemenetnek beolvassakor trtnik.
+			const float* samples = buffer.data() + run * hop;
+
+			if (mode == FTmode::FFT)
+				realPlan->Forward(samples, weights, result);
+			else if (mode == FTmode::DFT)
+			{
+				for (size_t j = 0; j < windowSize; j++)
+					window[j] = samples[j] * weights[j];
+				DFT(window, result);
+			}
+			else if (mode == FTmode::GOERTZEL)
+				bank->Process(samples, result);
+			else if (mode == FTmode::CQT)
+			{
+				// Az ablakozs a kernelekben van, ezrt a svkeret ablakozatlan spektruma kell. Az ebben
+				// az ablakban nem fut svok helyn 0 ll, gy az sszegbe nem kerlnek.
+				const size_t position = segmentRuns + run;
+				const size_t center = position * hop + frameSize / 2;
+				for (size_t b = 0; b < cqt->GetBandCount(); b++)
+				{
+					const CQTKernel::Band& band = cqt->GetBand(b);
+					if (position % band.Stride == 0)
+					{
+						band.Plan->Forward(pyramid->GetSamples(band.Level, (center >> band.Level) - band.FrameSize / 2), nullptr, window);
+						cqt->Apply(b, window, result);
+					}
+					else
+						std::fill(result.begin() + band.FirstBin, result.begin() + band.FirstBin + band.BinCount, std::complex<float>(0.0f, 0.0f));
+				}
+			}
+
+			for (size_t j = 0; j < spectrumSize; j++)
+				partial[j] += result[j];
+
+			if (magnitudes)
+			{
+				float* magnitude = magnitudePartials[chunk].data();
+				for (size_t j = 0; j < spectrumSize; j++)
+					magnitude[j] += std::sqrt(result[j].real() * result[j].real() + result[j].imag() * result[j].imag());
+			}
+
+			if (frameCallback && cqt)
+				bandFrames[run] = result;
+			else if (frameCallback)
+			{
+				PitchHistogram& chroma = frames[run].Chroma;
+				chroma.fill(0.0f);
+				if (chromaMap)
+					chromaMap->Fold(result, chroma);
+				else
+					ChromaMap::FoldNotes(result, spectrum.FirstMidi, spectrum.BinsPerSemitone, chroma);
+			}
+
+			if (fineFrames)
+			{
+				FineChroma& chroma = fines[run].Chroma;
+				chroma.fill(0.0f);
+				chromaMap->FoldFine(result, chroma);
+			}
+		}
+	};
+
+	while (true)
 	{
-		auto before = std::chrono::high_resolution_clock::now(); // Idmrs
+		if (cancel && *cancel)
+			throw AnalysisCancelled();
+
+		// A puffer feltltse a forrsbl
+		while (!endOfStream && available < batchSpan)
+		{
+			const size_t read = source.Read(buffer.data() + available, batchSpan - available);
+			if (read == 0)
+				endOfStream = true;
+			if (pyramid)
+				pyramid->Append(buffer.data() + available, read);
+			available += read;
+			totalSamples += read;
+		}
+		if (endOfStream && !tailPadded)
+		{
+			std::fill(buffer.begin() + available, buffer.begin() + available + pad, 0.0f);
+			if (pyramid)
+				pyramid->Append(buffer.data() + available, pad);
+			available += pad;
+			tailPadded = true;
+		}
 
-		// Jelenlegi ablak kivlasztsa
-		FTdata window(data.MonoData.begin() + i, data.MonoData.begin() + i + windowSize);
-		FTdata result(windowSize, 0.0f);
+		batchRuns = available >= frameSize ? std::min(batchWindows, (available - frameSize) / hop + 1) : 0;
+		if (batchRuns == 0)
+		{
+			// Szakasz vge (batchRuns csak a bemenet kirlsekor lehet 0): folytats a kvetkezvel
+			if (!source.NextSegment())
+				break;
+			std::fill(buffer.begin(), buffer.begin() + pad, 0.0f);
+			available = pad;
+			if (pyramid)
+			{
+				pyramid->Reset();
+				pyramid->Append(buffer.data(), pad);
+			}
+			endOfStream = false;
+			tailPadded = false;
+			segmentRuns = 0;
+			segmentStart = source.GetSegmentStart();
+			continue;
+		}
 
-		for (size_t j = 0; j < window.size(); j++)
-			window[j] *= 0.5f * (1.0f - std::cos(2.0f * PI * j / (windowSize - 1)));
+		const size_t chunkCount = (batchRuns + windowsPerChunk - 1) / windowsPerChunk;
+		if (pool)
+			pool->ParallelFor(chunkCount, processChunk);
+		else
+			for (size_t chunk = 0; chunk < chunkCount; chunk++)
+				processChunk(chunk);
 
-		if (mode == FTmode::FFT)
-			FFT(window, result);
-		else if (mode == FTmode::DFT)
-			DFT(window, result);
+		// Pronknti sszevons rgztett sorrendben: (0,1) (2,3) ..., majd (0,2) (4,6) ..., stb.
+		for (size_t stride = 1; stride < chunkCount; stride *= 2)
+			for (size_t target = 0; target + stride < chunkCount; target += 2 * stride)
+			{
+				for (size_t j = 0; j < spectrumSize; j++)
+					partials[target][j] += partials[target + stride][j];
+				for (size_t j = 0; j < magnitudeTotal.size(); j++)
+					magnitudePartials[target][j] += magnitudePartials[target + stride][j];
+			}
 
-		for (size_t j = 0; j < result.size(); j++)
-			out[j] += result[j] * (1.0f / totalRuns);
+		for (size_t j = 0; j < spectrumSize; j++)
+			total[j] += partials[0][j];
+		for (size_t j = 0; j < magnitudeTotal.size(); j++)
+			magnitudeTotal[j] += magnitudePartials[0][j];
+		runs += batchRuns;
 
-		auto after = std::chrono::high_resolution_clock::now();
-		auto dur = std::chrono::duration_cast<std::chrono::microseconds>(after - before).count() / 1000.0f;
-		runtime += dur;
+		// CQT-svok: a kirtkelsek szma, s az ablakonknti vektorokhoz a legutbbi eredmny
+		// (a szakasz els ablakban minden sv fut)
+		for (size_t run = 0; run < batchRuns && cqt; run++)
+		{
+			for (size_t b = 0; b < cqt->GetBandCount(); b++)
+			{
+				const CQTKernel::Band& band = cqt->GetBand(b);
+				if ((segmentRuns + run) % band.Stride != 0)
+					continue;
+				bandRuns[b]++;
+				if (frameCallback)
+					std::copy(bandFrames[run].begin() + band.FirstBin, bandFrames[run].begin() + band.FirstBin + band.BinCount, heldBands.begin() + band.FirstBin);
+			}
+
+			if (frameCallback)
+			{
+				frames[run].Chroma.fill(0.0f);
+				ChromaMap::FoldNotes(heldBands, spectrum.FirstMidi, spectrum.BinsPerSemitone, frames[run].Chroma);
+			}
+		}
+
+		if (frameCallback)
+		{
+			for (size_t run = 0; run < batchRuns; run++)
+				frames[run].Time = segmentStart + static_cast<double>((segmentRuns + run) * hop) / spectrum.SampleRate;
+			frameCallback(frames.data(), batchRuns);
+		}
+		if (fineFrames)
+		{
+			for (size_t run = 0; run < batchRuns; run++)
+				fines[run].Time = segmentStart + static_cast<double>((segmentRuns + run) * hop) / spectrum.SampleRate;
+			fineFrameCallback(fines.data(), batchRuns);
+		}
+		segmentRuns += batchRuns;
+
+		// A piramisbl a kvetkez ablak svkereteinl korbbi mintk eldobhatk.
+		if (pyramid)
+		{
+			const size_t center = segmentRuns * hop + frameSize / 2;
+			for (size_t level = 0; level < pyramid->GetLevelCount(); level++)
+			{
+				size_t first = std::numeric_limits<size_t>::max();
+				for (size_t b = 0; b < cqt->GetBandCount(); b++)
+					if (cqt->GetBand(b).Level == level)
+						first = std::min(first, (center >> level) - cqt->GetBand(b).FrameSize / 2);
+				pyramid->Discard(level, first);
+			}
+		}
+
+		// A feldolgozott ablakok mintit eldobjuk, az tfed maradk a puffer elejre kerl.
+		const size_t consumed = batchRuns * hop;
+		std::copy(buffer.begin() + consumed, buffer.begin() + available, buffer.begin());
+		available -= consumed;
+
+		if (progressCallback)
+			progressCallback(runs, expectedRuns);
 
 		// 50 futs utn vrhat idtartam kijelzse a felhasznlnak
-		if (runs == 50)
+		if (verbose && runs >= 50 && runs < expectedRuns && !estimatePrinted)
 		{
-			float estimatedSeconds = (totalRuns * (runtime / runs)) / 1000.0f;
+			estimatePrinted = true;
+			auto now = std::chrono::high_resolution_clock::now();
+			float elapsed = std::chrono::duration_cast<std::chrono::microseconds>(now - before).count() / 1000.0f;
+			float estimatedSeconds = (expectedRuns * (elapsed / runs)) / 1000.0f;
 			std::cout << "Estimated finish time: " << estimatedSeconds << "s\n";
 		}
 	}
 
+	const size_t totalRuns = static_cast<size_t>(std::floor(totalSamples / (windowSize * overlapFactor)));
+	// A ritkbban fut CQT-svok sszege a tbbiekvel azonos szm ablakra vettve
+	for (size_t b = 0; b < bandRuns.size(); b++)
+	{
+		const CQTKernel::Band& band = cqt->GetBand(b);
+		if (bandRuns[b] > 0)
+			for (size_t j = band.FirstBin; j < band.FirstBin + band.BinCount; j++)
+				total[j] *= static_cast<float>(runs) / bandRuns[b];
+	}
+
+	spectrum.Bins = std::move(total);
+	for (size_t j = 0; j < spectrumSize; j++)
+		spectrum.Bins[j] *= 1.0f / totalRuns;
+	spectrum.Magnitudes = std::move(magnitudeTotal);
+	for (float& magnitude : spectrum.Magnitudes)
+		magnitude *= 1.0f / totalRuns;
+
+	auto after = std::chrono::high_resolution_clock::now();
+	float runtime = std::chrono::duration_cast<std::chrono::microseconds>(after - before).count() / 1000.0f;
 	float avgTime = runtime / runs;
-	std::cout << runs << " FFT windows in total, elapsed: " << runtime / 1000.0f << "s, time/window: " << avgTime << "ms\n";
-	std::cout << "--------------------------------" << std::endl;
+	if (verbose)
+	{
+		std::cout << runs << " " << GetFTmodeName(mode) << " windows in total, elapsed: " << runtime / 1000.0f << "s, time/window: " << avgTime << "ms\n";
+		std::cout << "--------------------------------" << std::endl;
+	}
 
-	return out;
+	return spectrum;
 }
 
 // Lefuttatja a teljes fjlra a DFT-t, majd tlagolja a kapott spektrumot.
-FTdata Transformer::AvgDFT() const
+Spectrum Transformer::AvgDFT() const
 {	
 	return AvgFourier(FTmode::DFT);
 }
 
 // Lefuttatja a teljes fjlra az FFT-t, majd tlagolja a kapott spektrumot.
-FTdata Transformer::AvgFFT() const
+Spectrum Transformer::AvgFFT() const
 {
 	return AvgFourier(FTmode::FFT);
 }
 
+void Transformer::SetThreadPool(std::shared_ptr<ThreadPool> pool)
+{
+	this->pool = std::move(pool);
+}
+
+void Transformer::SetReferencePitch(const float referencePitch)
+{
+	this->referencePitch = referencePitch;
+}
+
+void Transformer::SetBinsPerSemitone(const unsigned binsPerSemitone)
+{
+	this->binsPerSemitone = binsPerSemitone;
+}
+
+void Transformer::SetFrameCallback(FrameCallback callback)
+{
+	frameCallback = std::move(callback);
+}
+
+void Transformer::SetFineFrameCallback(FineFrameCallback callback)
+{
+	fineFrameCallback = std::move(callback);
+}
+
+void Transformer::SetProgressCallback(ProgressCallback callback)
+{
+	progressCallback = std::move(callback);
+}
+
+void Transformer::SetVerbose(const bool verbose)
+{
+	this->verbose = verbose;
+}
+
+void Transformer::SetCancelFlag(const std::atomic<bool>* cancel)
+{
+	this->cancel = cancel;
+}
+
+void Transformer::SetMagnitudeAverage(const bool enabled)
+{
+	magnitudeAverage = enabled;
+}
+
+void Transformer::SetWindowType(const WindowType windowType)
+{
+	this->windowType = windowType;
+}
+
 void Transformer::SetWindowSize(const unsigned int windowSize)
 {
 	//Ablakmret korltozsok, 128 s 32768 kztt, s 2^x kell legyen!
@@ -155,7 +490,11 @@ void Transformer::SetWindowSize(const unsigned int windowSize)
 	}
 
 	if (isPowerOfTwo)
+	{
 		this->windowSize = windowSize;
+		plan = FFTPlan::Get(windowSize);
+		realPlan = RealFFTPlan::Get(windowSize);
+	}
 	else
 		throw std::invalid_argument("DFT/FFT window size is not a power of two!");
 }
@@ -1,24 +1,74 @@
 #pragma once
 
+#include <atomic>
+#include <functional>
+#include <stdexcept>
+
 #include "Structures.h"
+#include "AudioSource.h"
+#include "FFTPlan.h"
+#include "ThreadPool.h"
+#include "WindowFunction.h"
+#include "GoertzelBank.h"
+#include "CQTKernel.h"
+
+// A kvlrl megszaktott elemzs kivtele (Transformer::SetCancelFlag)
+class AnalysisCancelled : public std::runtime_error
+{
+public:
+	AnalysisCancelled() : std::runtime_error("Analysis cancelled") {}
+};
 
 class Transformer
 {
 public:
-	Transformer(const AudioData& audioData, const unsigned windowSize = 4096);
+	// Az ablakonknti hangosztly-vektorok tvtele ktegenknt, idrendben (a hv szln)
+	using FrameCallback = std::function<void(const ChromaFrame* frames, const size_t count)>;
+	// Ugyanez finom felbonts hangosztly-vektorokkal (csak FFT/DFT mdban)
+	using FineFrameCallback = std::function<void(const FineChromaFrame* frames, const size_t count)>;
+	// Haladsjelzs ktegenknt (nem ablakonknt), a hv szln: az eddig feldolgozott s a vrhat
+	// ablakszm (ez utbbi 0, ha a forrs hossza ismeretlen)
+	using ProgressCallback = std::function<void(const size_t windows, const size_t expectedWindows)>;
+
+	Transformer(AudioSource& audioSource, const unsigned windowSize = 4096);
 
 	void DFT(const FTdata& window, FTdata& result) const;
 	void FFT(const FTdata& window, FTdata& result) const;
 
-	FTdata AvgFourier(FTmode mode) const;
-	FTdata AvgDFT() const;
-	FTdata AvgFFT() const;
+	Spectrum AvgFourier(FTmode mode) const;
+	Spectrum AvgDFT() const;
+	Spectrum AvgFFT() const;
 
 	void SetWindowSize(const unsigned int windowSize);
+	void SetThreadPool(std::shared_ptr<ThreadPool> pool);
+	void SetWindowType(const WindowType windowType);
+	void SetReferencePitch(const float referencePitch);
+	void SetBinsPerSemitone(const unsigned binsPerSemitone);
+	void SetFrameCallback(FrameCallback callback);
+	void SetFineFrameCallback(FineFrameCallback callback);
+	void SetProgressCallback(ProgressCallback callback);
+	void SetMagnitudeAverage(const bool enabled);
+	void SetVerbose(const bool verbose);
+	// Ha a jelz igazra vlt, az AvgFourier a kvetkez kteg eltt AnalysisCancelled kivtelt dob.
+	void SetCancelFlag(const std::atomic<bool>* cancel);
+	inline WindowType GetWindowType() const { return windowType; }
 	inline unsigned int GetWindowSize() const { return windowSize; }
+	inline unsigned int GetHopSize() const { return windowSize / 2; }
 
 private:
-	const AudioData& data;
+	AudioSource& source;
 	unsigned windowSize;
+	WindowType windowType = WindowType::Hann;
+	float referencePitch = 440.0f; // a hangkzpont (GOERTZEL, CQT) mdokban s az ablakonknti hangosztly-vektoroknl szmt
+	unsigned binsPerSemitone = 1; // csak CQT mdban szmt
+	std::shared_ptr<const FFTPlan> plan;
+	std::shared_ptr<const RealFFTPlan> realPlan;
+	std::shared_ptr<ThreadPool> pool;
+	FrameCallback frameCallback;
+	FineFrameCallback fineFrameCallback;
+	ProgressCallback progressCallback;
+	const std::atomic<bool>* cancel = nullptr;
+	bool verbose = true; // folyamat s idmrs kirsa (ktegelt mdban kikapcsolva)
+	bool magnitudeAverage = false; // FFT/DFT mdban az amplitdspektrumok tlaga is (Spectrum::Magnitudes)
 };
 
@@ -0,0 +1,59 @@
+#include "WindowFunction.h"
+
+std::shared_ptr<const std::vector<float>> WindowFunction::Get(const WindowType type, const size_t size)
+{
+	static std::mutex cacheMutex;
+	static std::map<std::pair<WindowType, size_t>, std::shared_ptr<const std::vector<float>>> cache;
+
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	std::shared_ptr<const std::vector<float>>& table = cache[std::make_pair(type, size)];
+	if (!table)
+		table = std::make_shared<const std::vector<float>>(Build(type, size));
+	return table;
+}
+
+const char* WindowFunction::GetName(const WindowType type)
+{
+	switch (type)
+	{
+	case WindowType::Hamming:        return "Hamming";
+	case WindowType::BlackmanHarris: return "Blackman-Harris";
+	case WindowType::FlatTop:        return "flat-top";
+	default:                         return "Hann";
+	}
+}
+
+// Szimmetrikus, koszinuszsszeg alak ablakok: w[n] = a0 - a1*cos(x) + a2*cos(2x) - a3*cos(3x) + a4*cos(4x),
+// ahol x = 2*pi*n / (size - 1).
+std::vector<float> WindowFunction::Build(const WindowType type, const size_t size)
+{
+	std::array<double, 5> a{};
+	switch (type)
+	{
+	case WindowType::Hamming:
+		a = { 0.54, 0.46, 0.0, 0.0, 0.0 };
+		break;
+	case WindowType::BlackmanHarris: // 4 tag, -92 dB oldalhurok
+		a = { 0.35875, 0.48829, 0.14128, 0.01168, 0.0 };
+		break;
+	case WindowType::FlatTop: // pontos amplitd, szles fhurok
+		a = { 0.21557895, 0.41663158, 0.277263158, 0.083578947, 0.006947368 };
+		break;
+	default: // Hann
+		a = { 0.5, 0.5, 0.0, 0.0, 0.0 };
+		break;
+	}
+
+	std::vector<float> table(size, 1.0f);
+	if (size < 2)
+		return table;
+
+	for (size_t n = 0; n < size; n++)
+	{
+		const double x = 2.0 * 3.14159265358979323846 * n / (size - 1);
+		const double w = a[0] - a[1] * std::cos(x) + a[2] * std::cos(2 * x) - a[3] * std::cos(3 * x) + a[4] * std::cos(4 * x);
+		table[n] = static_cast<float>(w);
+	}
+
+	return table;
+}
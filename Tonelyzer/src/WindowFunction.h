@@ -0,0 +1,20 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+
+#include "Structures.h"
+
+// Ablakfggvny-tblk: (tpus, mret) pronknt egyszer szmoldnak ki, utna csak
+// szorztblaknt hasznljuk ket, gy ablakonknt nincs trigonometrikus fggvnyhvs.
+class WindowFunction
+{
+public:
+	static std::shared_ptr<const std::vector<float>> Get(const WindowType type, const size_t size);
+	static const char* GetName(const WindowType type);
+
+	// Gyorsttr nlkli tbla. A hangonknti (GoertzelBank, CQTKernel) ablakok hossza a
+	// referencia-hangmagassgtl fgg, ezrt azok ezt hasznljk, klnben a Get tblja a kiszolglban
+	// minden j hangmagassggal nne.
+	static std::vector<float> Build(const WindowType type, const size_t size);
+};
@@ -0,0 +1,191 @@
+#include <cstring>
+#include <functional>
+#include <memory>
+
+#include "libtonelyzer.h"
+#include "AnalyzerContext.h"
+#include "PitchAnalyzer.h"
+
+struct tlz_context
+{
+	std::unique_ptr<AnalyzerContext> Context;
+};
+
+// A hibaszveg szlanknt troldik, gy prhuzamos hvsok nem rjk fell egymst.
+static thread_local std::string lastError;
+
+static void CopyName(char* target, const size_t size, const std::string& name)
+{
+	std::strncpy(target, name.c_str(), size - 1);
+	target[size - 1] = '\0';
+}
+
+static void CopyKey(const KeyEstimate& estimate, tlz_key& key)
+{
+	CopyName(key.profile, sizeof(key.profile), estimate.Profile);
+	key.tonic = estimate.Key.first;
+	key.major = estimate.Key.second == 1 ? 1 : 0;
+	key.score = estimate.Score;
+	CopyName(key.name, sizeof(key.name), PitchAnalyzer::GetKeyName(estimate.Key));
+}
+
+// Az elemzs futtatsa: a C haladsjelz a megszakts-jelzt lltja, a kivtelek hibakdd vlnak.
+static int Run(const tlz_context* context, tlz_progress_fn progress, void* user, tlz_result* result,
+	const std::function<FileResult(const AnalyzerContext&, const AnalyzerContext::ProgressCallback&, const std::atomic<bool>*)>& analyze)
+{
+	lastError.clear();
+	if (!context || !result)
+	{
+		lastError = "Invalid argument";
+		return TLZ_ERROR;
+	}
+
+	std::atomic<bool> cancel(false);
+	AnalyzerContext::ProgressCallback callback;
+	if (progress)
+		callback = [&](const size_t windows, const size_t expectedWindows)
+		{
+			if (progress(user, windows, expectedWindows) != 0)
+				cancel = true;
+		};
+
+	try
+	{
+		const FileResult analysis = analyze(*context->Context, callback, &cancel);
+
+		std::memset(result, 0, sizeof(tlz_result));
+		std::copy(analysis.Histogram.begin(), analysis.Histogram.end(), result->histogram);
+		result->reference_pitch = analysis.ReferencePitch;
+		CopyKey(analysis.Keys.Ensemble, result->key);
+		result->family_count = std::min<size_t>(analysis.Keys.Families.size(), TLZ_MAX_FAMILIES);
+		for (size_t i = 0; i < result->family_count; i++)
+			CopyKey(analysis.Keys.Families[i], result->families[i]);
+		return TLZ_OK;
+	}
+	catch (const AnalysisCancelled& e)
+	{
+		lastError = e.what();
+		return TLZ_CANCELLED;
+	}
+	catch (const std::exception& e)
+	{
+		lastError = e.what();
+		return TLZ_ERROR;
+	}
+}
+
+extern "C"
+{
+
+void tlz_default_settings(tlz_settings* settings)
+{
+	const InitData defaults;
+	settings->mode = static_cast<int>(defaults.FourierMode);
+	settings->window = static_cast<int>(defaults.Window);
+	settings->window_size = defaults.FTWindowSize;
+	settings->bins_per_semitone = defaults.BinsPerSemitone;
+	settings->reference_pitch = defaults.ReferencePitch;
+	settings->estimate_tuning = defaults.EstimateTuning ? 1 : 0;
+	settings->decimate = defaults.Input.Decimate ? 1 : 0;
+	settings->threads = defaults.ThreadCount;
+	settings->profiles = nullptr;
+}
+
+tlz_context* tlz_create(const tlz_settings* settings)
+{
+	lastError.clear();
+	tlz_settings values;
+	tlz_default_settings(&values);
+	if (settings)
+		values = *settings;
+
+	if (values.mode < TLZ_MODE_FFT || values.mode > TLZ_MODE_CQT || values.window < TLZ_WINDOW_HANN || values.window > TLZ_WINDOW_FLAT_TOP)
+	{
+		lastError = "Invalid transform mode or window function";
+		return nullptr;
+	}
+
+	InitData init;
+	init.FourierMode = static_cast<FTmode>(values.mode);
+	init.Window = static_cast<WindowType>(values.window);
+	init.FTWindowSize = values.window_size;
+	init.BinsPerSemitone = values.bins_per_semitone;
+	init.ReferencePitch = values.reference_pitch;
+	init.EstimateTuning = values.estimate_tuning != 0;
+	init.Input.Decimate = values.decimate != 0;
+	init.ThreadCount = values.threads;
+	if (values.profiles)
+		init.Profiles = ParseProfiles(values.profiles);
+
+	try
+	{
+		std::unique_ptr<tlz_context> context(new tlz_context());
+		context->Context.reset(new AnalyzerContext(init));
+		return context.release();
+	}
+	catch (const std::exception& e)
+	{
+		lastError = e.what();
+		return nullptr;
+	}
+}
+
+void tlz_destroy(tlz_context* context)
+{
+	delete context;
+}
+
+int tlz_analyze_f32(const tlz_context* context, const float* interleaved, size_t frames, unsigned sample_rate, unsigned channels,
+	tlz_progress_fn progress, void* user, tlz_result* result)
+{
+	return Run(context, progress, user, result, [&](const AnalyzerContext& analyzer, const AnalyzerContext::ProgressCallback& callback, const std::atomic<bool>* cancel)
+	{
+		return analyzer.Analyze(interleaved, frames, sample_rate, channels, callback, cancel);
+	});
+}
+
+int tlz_analyze_s16(const tlz_context* context, const int16_t* interleaved, size_t frames, unsigned sample_rate, unsigned channels,
+	tlz_progress_fn progress, void* user, tlz_result* result)
+{
+	return Run(context, progress, user, result, [&](const AnalyzerContext& analyzer, const AnalyzerContext::ProgressCallback& callback, const std::atomic<bool>* cancel)
+	{
+		return analyzer.Analyze(interleaved, frames, sample_rate, channels, callback, cancel);
+	});
+}
+
+int tlz_analyze_callback(const tlz_context* context, tlz_read_fn read, void* read_user, unsigned sample_rate, unsigned channels,
+	tlz_progress_fn progress, void* user, tlz_result* result)
+{
+	if (!read)
+	{
+		lastError = "Invalid argument";
+		return TLZ_ERROR;
+	}
+
+	return Run(context, progress, user, result, [&](const AnalyzerContext& analyzer, const AnalyzerContext::ProgressCallback& callback, const std::atomic<bool>* cancel)
+	{
+		return analyzer.Analyze([&](float* interleaved, const size_t frames) { return read(read_user, interleaved, frames); },
+			sample_rate, channels, callback, cancel);
+	});
+}
+
+int tlz_analyze_file(const tlz_context* context, const char* path, tlz_progress_fn progress, void* user, tlz_result* result)
+{
+	if (!path)
+	{
+		lastError = "Invalid argument";
+		return TLZ_ERROR;
+	}
+
+	return Run(context, progress, user, result, [&](const AnalyzerContext& analyzer, const AnalyzerContext::ProgressCallback& callback, const std::atomic<bool>* cancel)
+	{
+		return analyzer.AnalyzeFile(path, callback, cancel);
+	});
+}
+
+const char* tlz_last_error(void)
+{
+	return lastError.c_str();
+}
+
+}
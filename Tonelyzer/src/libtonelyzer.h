@@ -0,0 +1,101 @@
+#ifndef LIBTONELYZER_H
+#define LIBTONELYZER_H
+
+/* A begyazhat knyvtr (libtonelyzer) C fellete; a C++ megfelelje az AnalyzerContext.
+ * Egy kontextus ltrehozs utn nem vltozik, gy tbb szlrl egyszerre is hasznlhat; a hvsok
+ * a kontextus szlkszletn osztoznak. A knyvtr nem r a konzolra: a haladsrl az opcionlis
+ * visszahvs rtest, a hibk szvege a tlz_last_error fggvnnyel krdezhet le. */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Visszatrsi rtkek */
+#define TLZ_OK 0
+#define TLZ_ERROR (-1)
+#define TLZ_CANCELLED (-2)
+
+/* Transzformcis mdok (a -dft / -goertzel / -cqt kapcsolk) */
+#define TLZ_MODE_FFT 0
+#define TLZ_MODE_DFT 1
+#define TLZ_MODE_GOERTZEL 2
+#define TLZ_MODE_CQT 3
+
+/* Ablakfggvnyek (a -win kapcsol) */
+#define TLZ_WINDOW_HANN 0
+#define TLZ_WINDOW_HAMMING 1
+#define TLZ_WINDOW_BLACKMAN_HARRIS 2
+#define TLZ_WINDOW_FLAT_TOP 3
+
+#define TLZ_MAX_FAMILIES 8
+
+typedef struct tlz_context tlz_context;
+
+typedef struct tlz_settings
+{
+	int mode;                   /* TLZ_MODE_* */
+	int window;                 /* TLZ_WINDOW_* */
+	unsigned window_size;       /* ketthatvny 128 s 32768 kztt */
+	unsigned bins_per_semitone; /* CQT mdban 1 vagy 3 */
+	float reference_pitch;      /* A4 frekvencija Hz-ben */
+	int estimate_tuning;        /* nem 0: a referencia-hangmagassg becslse (FFT/DFT mdban) */
+	int decimate;               /* nem 0: lsimt alulmintavtelezs a transzformci eltt */
+	unsigned threads;           /* 0: a hardver ltal tmogatott szlak szma */
+	const char* profiles;       /* "nev[:suly],..." vagy "all"; NULL: csak Krumhansl-Kessler */
+} tlz_settings;
+
+typedef struct tlz_key
+{
+	char profile[32]; /* a profilcsald neve; az egyttes dntsnl "Ensemble", ill. egyetlen csaldnl annak neve */
+	int tonic;        /* 0 (C) ... 11 (B) */
+	int major;        /* 1: dr, 0: moll */
+	float score;      /* korrelci */
+	char name[16];    /* pl. "F# minor" */
+} tlz_key;
+
+typedef struct tlz_result
+{
+	float histogram[12];  /* hangosztly-hisztogram, C-tl B-ig */
+	float reference_pitch; /* a hasznlt (becslskor a becslt) A4 frekvencia */
+	tlz_key key;           /* az egyttes dnts */
+	size_t family_count;
+	tlz_key families[TLZ_MAX_FAMILIES];
+} tlz_result;
+
+/* Haladsjelzs ktegenknt, a hv szln: feldolgozott s vrhat ablakszm (0, ha ismeretlen).
+ * Nem 0 visszatrsi rtk az elemzst megszaktja (TLZ_CANCELLED). */
+typedef int (*tlz_progress_fn)(void* user, size_t windows, size_t expected_windows);
+
+/* Legfeljebb frames kpkockt r az tlapolt float pufferbe; a bertak szma, 0: a jel vge.
+ * Az elemzs igny szerint, kis blokkokban hvja (a jel nem kerl egszben a memriba), a
+ * tlz_analyze_callback hv szln; a vrhat ablakszm ezrt ismeretlen (0). */
+typedef size_t (*tlz_read_fn)(void* user, float* interleaved, size_t frames);
+
+/* A parancssori alaprtkek (FFT, Hann, 16384, 440 Hz, Krumhansl-Kessler) */
+void tlz_default_settings(tlz_settings* settings);
+
+/* NULL bellts: alaprtkek. Hiba esetn NULL (lsd tlz_last_error). */
+tlz_context* tlz_create(const tlz_settings* settings);
+void tlz_destroy(tlz_context* context);
+
+/* tlapolt float (-1..1) vagy 16 bites PCM jel, visszahvsbl olvasott jel, ill. hangfjl elemzse.
+ * A progress elhagyhat (NULL). */
+int tlz_analyze_f32(const tlz_context* context, const float* interleaved, size_t frames, unsigned sample_rate, unsigned channels,
+	tlz_progress_fn progress, void* user, tlz_result* result);
+int tlz_analyze_s16(const tlz_context* context, const int16_t* interleaved, size_t frames, unsigned sample_rate, unsigned channels,
+	tlz_progress_fn progress, void* user, tlz_result* result);
+int tlz_analyze_callback(const tlz_context* context, tlz_read_fn read, void* read_user, unsigned sample_rate, unsigned channels,
+	tlz_progress_fn progress, void* user, tlz_result* result);
+int tlz_analyze_file(const tlz_context* context, const char* path, tlz_progress_fn progress, void* user, tlz_result* result);
+
+/* A hv szl utols hibjnak szvege (res, ha nem volt hiba) */
+const char* tlz_last_error(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -2,22 +2,141 @@
 #include "Reader.h"
 #include "Transformer.h"
 #include "PitchAnalyzer.h"
+#include "KeyTracker.h"
+#include "ChromaWriter.h"
+#include "ChromaMap.h"
+#include "BatchAnalyzer.h"
+#include "ResultCache.h"
+#include "SpectrumSidecar.h"
+#include "AnalysisServer.h"
+#include "LiveAnalyzer.h"
 
-int main(int argc, char* argv[])
+// Hangolsbecsls, hisztogram, hangnembecsls, a gyorsttr frisstse s a kirs; a spektrum
+// a transzformcibl vagy egy spektrumfjlbl szrmazik.
+static void ReportKeys(const PitchAnalyzer& analyzer, const InitData& init, ResultCache* cache, const FileIdentity& identity, const uint64_t parameterHash)
 {
-	if (argc < 2)
+	// Hangolsbecsls ugyanabbl a menetbl: a hisztogram mr a becslt referencia-hangmagassgra kpzdik.
+	float referencePitch = init.ReferencePitch;
+	if (init.EstimateTuning)
 	{
-		std::cout << "Tonelyzer syntax: <executable_name> <input_file> [-dft] [-f=440] [-w=16384]" << std::endl;
-		return 1;
+		if (!analyzer.CanEstimateTuning())
+			std::cerr << "Tuning estimation needs FFT or DFT mode, using " << referencePitch << " Hz." << std::endl;
+		else
+		{
+			const float cents = analyzer.EstimateTuning(init.ReferencePitch);
+			referencePitch = init.ReferencePitch * std::pow(2.0f, cents / 1200.0f);
+			std::cout << "Estimated tuning: " << cents << " cents (A4 = " << referencePitch << " Hz)" << std::endl;
+		}
+	}
+
+	const PitchHistogram histogram = analyzer.CalculateHistogram(referencePitch);
+	const KeyAnalysis keys = analyzer.CalculateKeys(histogram);
+
+	if (cache)
+	{
+		FileResult result;
+		result.ReferencePitch = referencePitch;
+		result.Histogram = histogram;
+		result.Keys = keys;
+		cache->Store(identity, parameterHash, result);
 	}
 
+	// Hangnem kiratsa
+	analyzer.PrintKeys(keys);
+}
+
+int main(int argc, char* argv[])
+{
 	// Inicializcis adatok
 	const InitData init = GetInitData(argc, argv);
 
-	// Olvas
-	AudioData read;
+	// Kiszolgl md: a krsek egy helyi socketen rkeznek
+	if (!init.ServePath.empty())
+	{
+		AnalysisServer server(init);
+		return server.Run();
+	}
+
+	// l bemenet: nyers PCM a szabvnyos bemenetrl, vagy a megadott fjlbl / csbl
+	if (init.Live.Enabled)
+	{
+		std::FILE* input = init.Inputs.empty() ? stdin : std::fopen(init.Inputs[0].c_str(), "rb");
+		if (!input)
+		{
+			std::cerr << "Cannot open " << init.Inputs[0] << std::endl;
+			return 1;
+		}
+
+		LiveAnalyzer live(init);
+		const int status = live.Run(input);
+		if (input != stdin)
+			std::fclose(input);
+		return status;
+	}
+
+	if (init.Inputs.empty())
+	{
+		std::cout << "Tonelyzer syntax: <executable_name> <input_file | directory | @file_list> ... [-dft | -goertzel | -cqt] [-bps=1] [-decimate] [-mix=avg] [-start=0] [-duration=60] [-range=90-150] [-profiles=krumhansl] [-track=10] [-chroma=out.npy | -chroma16=out.npy] [-f=440 | -f=auto] [-w=16384] [-j=N] [-win=hann] [-cache=tonelyzer.cache] [-sidecar[=dir]] [-serve=socket] [-live=s16 -rate=44100 -channels=2 -decay=8]" << std::endl;
+		return 1;
+	}
+
+	// Ktegelt md: tbb bemenet, knyvtr vagy listafjl, kzs szlkszleten
+	if (init.Inputs.size() > 1 || BatchAnalyzer::IsBatchInput(init.Inputs[0]))
+	{
+		BatchAnalyzer batch(init);
+		return batch.Run(BatchAnalyzer::CollectInputs(init.Inputs)) == 0 ? 0 : 1;
+	}
+
+	// Tarts gyorsttr s spektrumfjl: vltozatlan fjlnl a trolt eredmny, ill. spektrum, dekdols
+	// nlkl. Hangnemkvetshez s kromagram-kirshoz az ablakok kellenek, ezrt ott nem hasznljuk ket.
+	std::unique_ptr<ResultCache> cache;
+	FileIdentity identity;
+	const uint64_t parameterHash = ResultCache::GetParameterHash(init);
+	const bool reusable = init.TrackSpan <= 0.0 && init.ChromaPath.empty();
+	const bool identified = reusable && (!init.CachePath.empty() || init.SpectrumSidecar) && ResultCache::GetFileIdentity(init.Inputs[0], identity);
+	if (identified && !init.CachePath.empty())
+	{
+		try {
+			cache.reset(new ResultCache(init.CachePath));
+		}
+		catch (const std::exception& e)
+		{
+			std::cerr << e.what() << ", continuing without the cache." << std::endl;
+		}
+
+		FileResult cached;
+		if (cache && cache->Find(identity, parameterHash, cached))
+		{
+			std::cout << "Tonelyzer: Cached result for " << init.Inputs[0] << std::endl;
+			if (init.EstimateTuning)
+				std::cout << "Estimated tuning: A4 = " << cached.ReferencePitch << " Hz" << std::endl;
+
+			Spectrum empty;
+			PitchAnalyzer(empty).PrintKeys(cached.Keys);
+			return 0;
+		}
+	}
+
+	std::string sidecarPath;
+	const uint64_t transformHash = SpectrumSidecar::GetParameterHash(init);
+	if (identified && init.SpectrumSidecar)
+	{
+		sidecarPath = SpectrumSidecar::GetPath(init.Inputs[0], init.SidecarDirectory, identity, transformHash);
+		const std::unique_ptr<SpectrumSidecar> sidecar = SpectrumSidecar::Open(sidecarPath, identity, transformHash);
+		if (sidecar)
+		{
+			std::cout << "Tonelyzer: Using the stored spectrum " << sidecarPath << std::endl;
+			PitchAnalyzer analyzer(*sidecar);
+			analyzer.SetProfiles(init.Profiles);
+			ReportKeys(analyzer, init, cache.get(), identity, parameterHash);
+			return 0;
+		}
+	}
+
+	// Folyamatos olvas (igny szerinti lsimt alulmintavtelezssel)
+	std::unique_ptr<AudioSource> reader;
 	try {
-		read = Reader::ReadAudio(argv[1]);
+		reader = Reader::Open(init.Inputs[0], init.Input);
 	} 
 	catch (const std::exception& e) 
 	{
@@ -26,17 +145,119 @@ int main(int argc, char* argv[])
 		return 1;
 	}
 
+	// Alulmintavtelezsnl az ablakmret a ritkts arnyban cskken, gy a frekvenciafelbonts
+	// (mintavteli frekvencia / ablakmret) vltozatlan marad.
+	unsigned windowSize = init.FTWindowSize;
+	const unsigned factor = reader->GetDecimationFactor();
+	if (factor > 1)
+	{
+		std::cout << "Tonelyzer: Decimating " << reader->GetSampleRate() * factor << " Hz to " << reader->GetSampleRate() << " Hz (factor " << factor << ")" << std::endl;
+		windowSize = std::max(128u, windowSize / factor);
+	}
+
+	const std::shared_ptr<ThreadPool> pool = std::make_shared<ThreadPool>(init.ThreadCount);
+
+	// -f=auto hangnemkvetssel vagy kromagrammal: a hangols csak a teljes tlagspektrumbl becslhet,
+	// ezrt a transzformci kzben flhangonknt FineChromaResolution osztly vektorok gylnek, s csak
+	// a becsls utn forognak 12 osztlyra a kvets s a kirs szmra (egyetlen menet a fjlon).
+	const bool framed = init.TrackSpan > 0.0 || !init.ChromaPath.empty();
+	const bool deferFrames = framed && init.EstimateTuning && (init.FourierMode == FTmode::FFT || init.FourierMode == FTmode::DFT);
+	std::vector<FineChromaFrame> fineFrames;
+
 	// Fourier-transzformcit vgz egysg
-	const Transformer tr(read, init.FTWindowSize);
-	const FTdata output = tr.AvgFourier(init.FourierMode);
+	Transformer tr(*reader, windowSize);
+	tr.SetThreadPool(pool);
+	tr.SetWindowType(init.Window);
+	tr.SetReferencePitch(init.ReferencePitch);
+	tr.SetBinsPerSemitone(init.BinsPerSemitone);
+	tr.SetMagnitudeAverage(init.EstimateTuning || !sidecarPath.empty()); // a spektrumfjl ksbbi -f=auto futshoz is elg legyen
 
-	// Hangmagassg elemz egysg
-	const PitchAnalyzer analyzer(read, output);
-	const PitchHistogram histogram = analyzer.CalculateHistogram(init.ReferencePitch);
-	const KeyPair key = analyzer.CalculateKeyKrumhansl(histogram);
+	// Hangmagassg elemz egysg (a spektrum a transzformci utn kerl bele)
+	Spectrum output;
+	PitchAnalyzer analyzer(output);
+	analyzer.SetProfiles(init.Profiles);
 
-	// Hangnem kiratsa
-	analyzer.PrintKeyKrumhansl(key);
+	// Idbeli hangnemkvets s kromagram-kirs: az ablakok hangosztly-vektorai a transzformci
+	// kzben, ktegenknt rkeznek.
+	std::unique_ptr<KeyTracker> tracker;
+	if (init.TrackSpan > 0.0)
+		tracker.reset(new KeyTracker(analyzer, init.TrackSpan, tr.GetHopSize() / static_cast<double>(reader->GetSampleRate())));
+
+	std::unique_ptr<ChromaWriter> chromaWriter;
+	if (!init.ChromaPath.empty())
+	{
+		try {
+			chromaWriter.reset(new ChromaWriter(init.ChromaPath, init.ChromaHalf, reader->GetSampleRate(), tr.GetHopSize(), tr.GetWindowSize(), init.ReferencePitch));
+		}
+		catch (const std::exception& e)
+		{
+			std::cerr << e.what() << std::endl;
+			return 1;
+		}
+	}
+
+	if (deferFrames)
+	{
+		tr.SetFineFrameCallback([&fineFrames](const FineChromaFrame* frames, const size_t count)
+		{
+			fineFrames.insert(fineFrames.end(), frames, frames + count);
+		});
+	}
+	else if (tracker || chromaWriter)
+	{
+		tr.SetFrameCallback([&tracker, &chromaWriter](const ChromaFrame* frames, const size_t count)
+		{
+			if (chromaWriter)
+				chromaWriter->Write(frames, count);
+			if (tracker)
+				for (size_t i = 0; i < count; i++)
+					tracker->Push(frames[i]);
+		});
+	}
+
+	output = tr.AvgFourier(init.FourierMode);
+
+	if (deferFrames)
+	{
+		const PitchAnalyzer tuningAnalyzer(output);
+		const float cents = tuningAnalyzer.CanEstimateTuning() ? tuningAnalyzer.EstimateTuning(init.ReferencePitch) : 0.0f;
+		if (chromaWriter)
+			chromaWriter->SetReferencePitch(init.ReferencePitch * std::pow(2.0f, cents / 1200.0f));
+
+		ChromaFrame frame;
+		for (const FineChromaFrame& fine : fineFrames)
+		{
+			frame.Time = fine.Time;
+			frame.Chroma.fill(0.0f);
+			ChromaMap::Rotate(fine.Chroma, cents, frame.Chroma);
+			if (chromaWriter)
+				chromaWriter->Write(&frame, 1);
+			if (tracker)
+				tracker->Push(frame);
+		}
+		fineFrames.clear();
+	}
+
+	// A kromagram rsi hibja nem szaktja meg az elemzst, de a kilpsi kd jelzi.
+	int status = 0;
+	if (chromaWriter)
+	{
+		if (chromaWriter->Close())
+			std::cout << "Tonelyzer: " << chromaWriter->GetFrameCount() << " chroma frames written to " << init.ChromaPath << std::endl;
+		else
+		{
+			std::cerr << "Cannot write the chromagram file " << init.ChromaPath << std::endl;
+			status = 1;
+		}
+	}
+
+	if (tracker)
+		tracker->Print();
+
+	if (!sidecarPath.empty() && !SpectrumSidecar::Write(sidecarPath, identity, transformHash, output))
+		std::cerr << "Cannot write the spectrum file " << sidecarPath << std::endl;
+
+	ReportKeys(analyzer, init, cache.get(), identity, parameterHash);
 
-	return 0;
+	return status;
 }
\ No newline at end of file
@@ -0,0 +1,137 @@
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "Transformer.h"
+#include "FFTPlan.h"
+#include "FFTKernels.h"
+#include "BufferSource.h"
+
+// Az FFTPlan (komplex) s a RealFFTPlan (vals bemenet) eredmnynek sszevetse a
+// Transformer::DFT-vel minden leglis ablakmreten (128 - 32768), a skalr, SSE2 s AVX2
+// kdton; a processzoron nem futtathat kdt kimarad. A hiba a relatv ngyzetes kzphiba,
+// ||X_fft - X_ref|| / ||X_ref||, kt referencival:
+//  - Transformer::DFT: korlt 4 * N * 2^-24. Itt a DFT sajt hibja dominl: a 2*pi*k*n/N
+//    fzisszg float kerektse a k*n szorzattal, vagyis N-nel arnyosan n (mrten kb. 1.6 * N * 2^-24).
+//  - pontos DFT double pontossggal, egy N elem forgatsi tblbl a (k*n) mod N indexszel:
+//    korlt 1e-7 * log2(N). Az FFT float hibja log2(N)-nel arnyos (mrten 1-1.5e-7); ez a szigor ellenrzs.
+// Egy mreten mindkt referencia egyszer kszl, az sszes kdt ezekhez mr.
+
+static double GetDftBound(const size_t size)
+{
+	return 4.0 * size * std::ldexp(1.0, -24);
+}
+
+static double GetExactBound(const size_t size)
+{
+	return 1e-7 * std::log2(static_cast<double>(size));
+}
+
+// Pontos DFT: a fzis egsz aritmetikval redukldik, az sszegzs double pontossg.
+static FTdata ExactDFT(const FTdata& input)
+{
+	const size_t size = input.size();
+	std::vector<std::complex<double>> table(size);
+	for (size_t i = 0; i < size; i++)
+		table[i] = std::polar(1.0, -2.0 * 3.14159265358979323846 * i / size);
+
+	FTdata result(size);
+	for (size_t k = 0; k < size; k++)
+	{
+		std::complex<double> sum = 0.0;
+		for (size_t n = 0; n < size; n++)
+			sum += std::complex<double>(input[n]) * table[(k * n) % size];
+		result[k] = std::complex<float>(sum);
+	}
+	return result;
+}
+
+// A vals rsz spektruma a komplex spektrumbl: X_re[k] = (X[k] + conj(X[N - k])) / 2
+static FTdata RealPart(const FTdata& spectrum)
+{
+	const size_t size = spectrum.size();
+	FTdata result(size / 2 + 1);
+	for (size_t k = 0; k <= size / 2; k++)
+		result[k] = 0.5f * (spectrum[k] + std::conj(spectrum[(size - k) % size]));
+	return result;
+}
+
+static double RelativeError(const std::complex<float>* actual, const std::complex<float>* expected, const size_t count)
+{
+	double error = 0.0, norm = 0.0;
+	for (size_t i = 0; i < count; i++)
+	{
+		error += std::norm(std::complex<double>(actual[i]) - std::complex<double>(expected[i]));
+		norm += std::norm(std::complex<double>(expected[i]));
+	}
+	return std::sqrt(error / norm);
+}
+
+static bool Check(const char* plan, const char* reference, const char* path, const size_t size, const double error, const double bound)
+{
+	const bool passed = error <= bound;
+	std::printf("%-8s %-6s %-6s %6zu  error %.3e  bound %.3e  %s\n", plan, reference, path, size, error, bound, passed ? "ok" : "FAILED");
+	return passed;
+}
+
+int main()
+{
+	const struct { FFTKernels::KernelPath Path; const char* Name; } paths[] = {
+		{ FFTKernels::KernelPath::Scalar, "scalar" },
+		{ FFTKernels::KernelPath::Sse2, "sse2" },
+		{ FFTKernels::KernelPath::Avx2, "avx2" }
+	};
+
+	// A Transformer::DFT-hez kell egy forrs; a jelt nem hasznlja.
+	const std::vector<float> silence(32768, 0.0f);
+	BufferSource source(silence.data(), silence.size(), 44100, 1);
+	const Transformer transformer(source);
+
+	std::mt19937 random(20240229);
+	std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+	size_t failures = 0;
+
+	for (size_t size = 128; size <= 32768; size *= 2)
+	{
+		FTdata input(size);
+		std::vector<float> real(size);
+		for (size_t i = 0; i < size; i++)
+		{
+			input[i] = std::complex<float>(uniform(random), uniform(random));
+			real[i] = input[i].real();
+		}
+
+		FTdata dft;
+		transformer.DFT(input, dft);
+		const FTdata exact = ExactDFT(input);
+		const FTdata dftReal = RealPart(dft);
+		const FTdata exactReal = RealPart(exact);
+
+		const FFTPlan plan(size);
+		const RealFFTPlan realPlan(size);
+		for (const auto& path : paths)
+		{
+			if (!FFTKernels::SetKernelPath(path.Path))
+			{
+				std::printf("%-6s %6zu  skipped (not supported by this CPU)\n", path.Name, size);
+				continue;
+			}
+
+			FTdata result, spectrum;
+			plan.Forward(input, result);
+			realPlan.Forward(real.data(), spectrum);
+
+			const size_t bins = size / 2 + 1;
+			failures += Check("complex", "dft", path.Name, size, RelativeError(result.data(), dft.data(), size), GetDftBound(size)) ? 0 : 1;
+			failures += Check("complex", "exact", path.Name, size, RelativeError(result.data(), exact.data(), size), GetExactBound(size)) ? 0 : 1;
+			failures += Check("real", "dft", path.Name, size, RelativeError(spectrum.data(), dftReal.data(), bins), GetDftBound(size)) ? 0 : 1;
+			failures += Check("real", "exact", path.Name, size, RelativeError(spectrum.data(), exactReal.data(), bins), GetExactBound(size)) ? 0 : 1;
+		}
+	}
+	FFTKernels::SetKernelPath(FFTKernels::KernelPath::Auto);
+
+	std::printf("%zu failure(s)\n", failures);
+	return failures == 0 ? 0 : 1;
+}